@@ -3,45 +3,204 @@
 
 #include "gamestate.hpp"
 #include "game_logic.hpp"
+#include "transposition.hpp"
+#include "move_ordering.hpp"
+#include "time_manager.hpp"
+#include "search_stack.hpp"
 
-#include <map>		// key-value container
-#include <limits>	// INFINITY
 #include <climits>	// INT_MIN, INT_MAX
+#include <cstdint>	// uint64_t
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>	// std::ref
+#include <mutex>
+#include <string>
 
-// Max value an integer can have (n <= MAX_INT)
-// const int MAX_INT = std::numeric_limits<int>::max();
-// Infinite value for a float (f < INFINITY)
-const float INFINITY = std::numeric_limits<float>::infinity();
+// Max depth for ID-DL-Minimax when no depth or time limit is given
+const int MAX_DEPTH = 3;
 
-// Max depth for ID-DL-Minimax
-const int MAX_DEPTH = 1;
+// Material values for each piece type, indexed by PAWN-KING
+const int MATERIAL_VALS[6] = {1, 3, 3, 5, 9, 0};
 
-// Material values for each piece
-const std::map<char,int> MATERIAL_VALS = 
+// Search scores are from the point of view of the player to move. Checkmate is worth
+// MATE_SCORE minus the number of plies it takes, so quicker mates score higher
+const int MATE_SCORE = 100000;
+const int MATE_THRESHOLD = MATE_SCORE - 1000;	// any score beyond this is a forced mate
+const int INFINITE_SCORE = 1000000;				// larger than any real score
+
+// Half the width of the first aspiration window around the last iteration's score, and the
+// depth limit where aspiration windows start being used (shallower scores jump around too much)
+const int ASPIRATION_WINDOW = 50;
+const int ASPIRATION_MIN_DEPTH = 2;
+
+// Once an aspiration window has grown past this, that side of the window is opened all the way
+const int ASPIRATION_MAX_WINDOW = 1000;
+
+// Null-move pruning is only tried this many plies or more from the depth limit, and the null move
+// is searched this many plies shallower than a real move would be (one more when depth is large)
+const int NULL_MOVE_MIN_DEPTH = 3;
+const int NULL_MOVE_REDUCTION = 2;
+
+// With at most this much non-pawn material (in PHASE_WEIGHTS, so a rook or two minor pieces)
+// zugzwang is likely, so a null-move cutoff has to be confirmed by a real search first
+const int NULL_MOVE_VERIFY_PHASE = 2;
+
+// Late move reductions apply to quiet moves after this many moves have been searched at a node,
+// at least this many plies from the depth limit
+const int LMR_MIN_MOVES = 3;
+const int LMR_MIN_DEPTH = 3;
+
+// Quiescence search skips a capture when even winning the captured piece plus this much would
+// not bring the score up to alpha
+const int DELTA_MARGIN = 200;
+
+// Most threads a search can be told to use
+const int MAX_SEARCH_THREADS = 256;
+
+// Pruning and reduction techniques that can be switched off at runtime, to compare the search
+// with and without them, and how many threads search at once
+class Search_Options
 {
-	{'P', 1}, {'p', 1},
-	{'B', 3}, {'b', 3},
-	{'N', 3}, {'n', 3},
-	{'R', 5}, {'r', 5},
-	{'Q', 9}, {'q', 9},
-	{'K', 0}, {'k', 0}
+public:
+	bool null_move_pruning = true;		// skip a turn; if still winning by beta, assume a real move is too
+	bool late_move_reductions = true;	// search quiet moves ordered late less deeply
+	int threads = 1;					// the main search thread plus this many - 1 helpers
+	bool uci_output = false;			// report progress as UCI "info" lines instead of the full report
 };
 
+Search_Options SEARCH_OPTIONS;
+
+// Results of earlier searches, shared across every depth, every move of the game, and every
+// search thread. Call TRANSPOSITION_TABLE.Resize() to change how much memory it uses
+Transposition_Table TRANSPOSITION_TABLE;
+
+// Everything below marked thread_local is kept separately by each search thread, so the threads
+// never write to the same memory except through the transposition table
+
+// Killer moves, history scores, and cutoff statistics used to order moves within the search
+thread_local Move_Orderer MOVE_ORDERER;
+
+// Move lists, undo records, and best lines for every ply of the running search
+thread_local Search_Stack SEARCH_STACK;
+
+// Number of positions visited by the search functions since it was last reset (ID_DL_Minimax()
+// resets it when it starts). After a search with helper threads, the main thread's count
+// includes the helpers' nodes
+thread_local uint64_t NODE_COUNT = 0;
+
+// 0 for the main search thread, and 1 and up for the helpers
+thread_local int THREAD_INDEX = 0;
+
+// Each helper's NODE_COUNT, published every so often so the main thread can report the total
+// while the search is still running
+std::atomic<uint64_t> HELPER_NODES[MAX_SEARCH_THREADS];
+
+// Held while writing a line of output, so lines from the search thread and the thread reading
+// commands never run together
+std::mutex OUTPUT_MUTEX;
+
+// Clock for the running search
+Time_Manager TIME_MANAGER;
+
+// Principal variation search statistics, since they were last reset: moves searched with a zero
+// window to prove they are no better than the best so far, and how many of those turned out
+// better and had to be searched again with the full window
+thread_local uint64_t PVS_SEARCHES = 0;
+thread_local uint64_t PVS_RESEARCHES = 0;
+
+// Null-move and late move reduction statistics, reset along with the ones above
+thread_local uint64_t NULL_MOVE_TRIES = 0;			// null moves searched
+thread_local uint64_t NULL_MOVE_CUTOFFS = 0;		// null moves that caused a cutoff
+thread_local uint64_t NULL_MOVE_VERIFY_FAILS = 0;	// cutoffs thrown out by the verification search
+thread_local uint64_t LMR_SEARCHES = 0;				// reduced searches
+thread_local uint64_t LMR_RESEARCHES = 0;			// reduced searches that beat alpha and were searched again
+
+// Depth limit of the last iteration ID_DL_Minimax() finished
+int LAST_COMPLETED_DEPTH = -1;
+
+// The opponent's reply ID_DL_Minimax() expects to the move it chose, or NULL_MOVE if it has none.
+// This is the position worth pondering on while the opponent thinks
+Move PONDER_MOVE = NULL_MOVE;
+
+// Set once the running search has run out of time, the main thread has finished and is stopping
+// the helpers, or another thread wants it to stop. Every search function returns straight away
+// after that, and the result of the unfinished iteration is thrown away. ID_DL_Minimax() clears
+// it again when it finishes (not when it starts, so a stop that comes in just before is not lost)
+std::atomic<bool> SEARCH_ABORTED(false);
+
 
 //////// Function Declarations ////////
 
-// Iteratively search the game tree up to the max depth, attempting to
-// find the best minimax move for the next player
-std::string ID_DL_Minimax(const Gamestate& g);
+// Iteratively search the game tree one depth deeper at a time, attempting to find the best
+// minimax move for the next player. Stops at the depth limit, or when the clock says there is no
+// time for another iteration, and returns the best move of the last iteration that finished.
+// With no limits at all, searches up to MAX_DEPTH
+Move ID_DL_Minimax(const Gamestate& g, const Search_Limits& limits = Search_Limits());
+
+// Lazy SMP helper thread: search the same position as the main thread with its own iterative
+// deepening loop, until the main thread sets SEARCH_ABORTED. Its results only reach the main thread
+// through the shared transposition table, where they speed up the main search and steer its move
+// ordering. Its node count is left in HELPER_NODES[thread_index]
+void Helper_Search(const Gamestate& g, const int thread_index, const int max_depth);
+
+// Called by every search thread every TIME_CHECK_INTERVAL nodes: publish a helper's node count,
+// or on the main thread, notice a ponder hit and set SEARCH_ABORTED once the time or node limit
+// is reached
+void Poll_Search();
+
+// Get the number of positions visited so far by the running search, over every thread. Only
+// meaningful on the main search thread
+uint64_t Total_Nodes();
+
+// Write one line to the console, without it getting mixed up with lines from other threads
+void Send_Line(const std::string line);
+
+// Format a search score the way UCI reports it: "cp <centipawns>", or "mate <moves>" for a forced
+// mate (negative if the player to move is the one getting mated)
+std::string UCI_Score(const int score);
+
+// Search the game tree up to the given depth limit with alpha-beta negamax, and return the
+// best move. Children of the root are searched "depth_limit" more plies deep. Between moves
+// with equal scores, the first one searched is chosen. If the search is aborted, the result
+// is meaningless and SEARCH_ABORTED is set
+Move DL_Minimax_Choice(const Gamestate& g, const int depth_limit);
+
+// Same as DL_Minimax_Choice(), but only looking for scores between alpha and beta. Returns the best
+// move and sets "best_score" to its score. A best_score <= alpha means every move is at most that
+// good, and a best_score >= beta means that move is at least that good (the window has to be
+// widened to find out more)
+Move Root_Search(const Gamestate& g, const int depth_limit, int alpha, const int beta, int& best_score);
+
+// Search a move that has just been made with principal variation search, returning its score for
+// the player who made it. The first move at a node is searched with the full window. Every later
+// move is first searched with a zero window (alpha, alpha + 1), which only proves whether it beats
+// alpha and is much cheaper, and is searched again with the full window only if it does. A move
+// with a "reduction" is first searched that many plies shallower, and at full depth only if it
+// beats alpha anyway
+int PV_Search_Child(Gamestate& g, const int depth, const int alpha, const int beta, const int ply, const bool first_move, const int reduction = 0);
+
+// Get the PHASE_WEIGHTS total of the given color's knights, bishops, rooks, and queens
+int Non_Pawn_Material(const Gamestate& g, const int color);
 
-// Recursively explore the game tree up to the given depth limit, and return the best move
-std::string DL_Minimax_Choice(const Gamestate& g, const int depth_limit);
+// Determine the value of the given game state for the player to move, searching "depth" more
+// plies. Scores at or below alpha only prove the value is <= alpha, and scores at or above beta
+// only prove the value is >= beta. "ply" is the distance from the root, used to score mates.
+// Moves are made and unmade on "g" in place, so it is back in its original state on return.
+// "allow_null_move" is false right after a null move, so two are never made in a row
+int Negamax(Gamestate& g, const int depth, int alpha, int beta, const int ply, const bool allow_null_move = true);
 
-// Determine the max value of the given game state
-float Max_Value(const Gamestate& g, const int depth);
+// Keep searching captures (and every move when in check) past the depth limit until the position
+// is quiet, so the heuristic is never taken in the middle of an exchange. The player to move can
+// also "stand pat" and take the heuristic score instead of capturing, since captures are never forced
+int Quiescence(Gamestate& g, int alpha, int beta, const int ply);
 
-// Determine the min value of the given game state
-float Min_Value(const Gamestate& g, const int depth);
+// Same as DL_Minimax_Choice(), but with plain full-width minimax and no transposition table.
+// Kept as a reference to check that alpha-beta finds the same moves while visiting fewer nodes
+Move Full_Minimax_Choice(const Gamestate& g, const int depth_limit, int& best_score);
+
+// Plain full-width minimax in negamax form, used by Full_Minimax_Choice()
+int Full_Minimax(Gamestate& g, const int depth, const int ply);
 
 // Determine the "score" of the given terminal game state
 // draw == 0
@@ -52,216 +211,811 @@ int Utility_Value(const Gamestate& g);
 // Determine the "score" of the given game state based on material advantage only
 int hValue_Material(const Gamestate& g);
 
+// Determine the heuristic score of the given game state for the player to move, in centipawns.
+// Blends the middlegame and endgame scores Gamestate keeps up to date, so it takes constant time
+int Evaluate(const Gamestate& g);
+
+// Convert mate scores between "plies from the root" (used by the search) and "plies from this
+// position" (stored in the transposition table, so the entry is valid at any ply)
+int Score_To_TT(const int score, const int ply);
+int Score_From_TT(const int score, const int ply);
+
 
 //////// Function Implementations ////////
 
-std::string ID_DL_Minimax(const Gamestate& g)
+Move ID_DL_Minimax(const Gamestate& g, const Search_Limits& limits)
 {
-	std::string action = "";
+	Move action = NULL_MOVE;
+
+	// Start the clock, and search until it runs out if there is one. A search limited only by
+	// nodes, or with no limit at all, goes as deep as the search can
+	TIME_MANAGER.Start(limits, g.next_turn);
+	NODE_COUNT = 0;
+	LAST_COMPLETED_DEPTH = -1;
+	PONDER_MOVE = NULL_MOVE;
+	bool unbounded = (TIME_MANAGER.timed || limits.infinite || limits.nodes > 0);
+
+	// A deeper limit than that is cut down to it, since the search stack and the killer tables
+	// have room for no more plies
+	int max_depth = (limits.depth >= 0 ? std::min(limits.depth, MAX_PLY - 1) : (unbounded ? MAX_PLY - 1 : MAX_DEPTH));
+	int64_t last_iteration_ms = 0;
+	int64_t previous_iteration_ms = 0;
+
+	// Count table usage and cutoffs for this move only, and mark the table's entries as coming
+	// from older searches. Killers from the last move are at the wrong plies now, and older
+	// history should count for less
+	TRANSPOSITION_TABLE.New_Search();
+	TRANSPOSITION_TABLE.Clear_Stats();
+	MOVE_ORDERER.Clear_Stats();
+	MOVE_ORDERER.Clear_Killers();
+	MOVE_ORDERER.Age_History();
+
+	// Start the helper threads, which search alongside this one until it is done
+	int num_threads = std::max(1, std::min(SEARCH_OPTIONS.threads, MAX_SEARCH_THREADS));
+	std::vector<std::thread> helpers;
+	for (int t = 1; t < MAX_SEARCH_THREADS; t++)
+	{
+		HELPER_NODES[t] = 0;
+	}
+	for (int t = 1; t < num_threads; t++)
+	{
+		helpers.push_back(std::thread(Helper_Search, std::ref(g), t, max_depth));
+	}
+
+	// Score of the last finished iteration, which the next one's aspiration window is centered on
+	int score = 0;
+
 	// Check each depth one at a time
-	for (int i = 0; i <= MAX_DEPTH; i++)
+	for (int i = 0; i <= max_depth; i++)
 	{
 		// DL minimax with depth limit = i
-		std::cout << "Depth: " << i << "\n";
-		action = DL_Minimax_Choice(g, i);
+		if (!SEARCH_OPTIONS.uci_output)
+		{
+			std::cout << "Depth: " << i << "\n";
+		}
+		int64_t iteration_start = TIME_MANAGER.Search_Ms();
+		PVS_SEARCHES = 0;
+		PVS_RESEARCHES = 0;
+		NULL_MOVE_TRIES = 0;
+		NULL_MOVE_CUTOFFS = 0;
+		NULL_MOVE_VERIFY_FAILS = 0;
+		LMR_SEARCHES = 0;
+		LMR_RESEARCHES = 0;
+
+		// The score usually changes little from one depth to the next, so look only close to the
+		// last one at first. A narrow window prunes much more, but if the true score is outside
+		// it the search only finds a bound and has to be repeated with a wider window
+		int window = ASPIRATION_WINDOW;
+		int alpha = -INFINITE_SCORE;
+		int beta = INFINITE_SCORE;
+		if (i >= ASPIRATION_MIN_DEPTH && abs(score) < MATE_THRESHOLD)
+		{
+			alpha = score - window;
+			beta = score + window;
+		}
+
+		Move choice = NULL_MOVE;
+		int searches = 0;
+		while (true)
+		{
+			searches++;
+			int last_score = score;
+			choice = Root_Search(g, i, alpha, beta, score);
+			if (SEARCH_ABORTED)
+			{
+				score = last_score;
+				break;
+			}
+
+			// Widen whichever side failed, giving up on that side once it is wide enough
+			window *= 4;
+			if (score <= alpha)
+			{
+				alpha = (window > ASPIRATION_MAX_WINDOW ? -INFINITE_SCORE : score - window);
+			}
+			else if (score >= beta)
+			{
+				beta = (window > ASPIRATION_MAX_WINDOW ? INFINITE_SCORE : score + window);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		// An aborted iteration has not looked at every move, so keep the last complete result.
+		// Even the first iteration is kept if it is all there is
+		if (SEARCH_ABORTED && action != NULL_MOVE)
+		{
+			if (!SEARCH_OPTIONS.uci_output)
+			{
+				std::cout << "\tOut of time, keeping the move from depth " << i - 1 << "\n";
+			}
+			break;
+		}
+		action = choice;
+		if (!SEARCH_ABORTED)
+		{
+			LAST_COMPLETED_DEPTH = i;
 
-		// Check time if that is a factor
+			// The second move of the principal variation is the reply it expects
+			const Search_Ply& root = SEARCH_STACK.plies[0];
+			PONDER_MOVE = (root.pv_length > 1 && root.pv[0] == action ? root.pv[1] : NULL_MOVE);
+		}
+
+		if (SEARCH_OPTIONS.uci_output)
+		{
+			// Only a finished iteration has a line worth reporting. UCI counts depth in plies
+			// from the root, and the root move itself is one of them
+			if (SEARCH_ABORTED)
+			{
+				break;
+			}
+			int64_t elapsed = TIME_MANAGER.Search_Ms();
+			uint64_t nodes = Total_Nodes();
+			std::string pv = SEARCH_STACK.PV_String();
+			Send_Line("info depth " + std::to_string(i + 1) + " score " + UCI_Score(score)
+					  + " nodes " + std::to_string(nodes) + " nps " + std::to_string(elapsed > 0 ? nodes * 1000 / elapsed : nodes)
+					  + " time " + std::to_string(elapsed) + " pv " + (pv.empty() ? Move_to_UCI(action) : pv));
+		}
+		else
+		{
+			std::cout << "\tBest move for " << g.next_turn << " is " << Move_to_UCI(action) << " (score " << score << ")\n";
+			std::cout << "\tPrincipal variation: " << SEARCH_STACK.PV_String() << "\n";
+			std::cout << "\tSearches: " << searches << " at the root (" << searches - 1 << " re-searched after missing the aspiration window)"
+					  << ", " << PVS_SEARCHES << " zero-window (" << PVS_RESEARCHES << " re-searched, "
+					  << (PVS_SEARCHES ? 100 * PVS_RESEARCHES / PVS_SEARCHES : 0) << "%)\n";
+			std::cout << "\tNull moves: " << NULL_MOVE_TRIES << " tried, " << NULL_MOVE_CUTOFFS << " cutoffs ("
+					  << NULL_MOVE_VERIFY_FAILS << " failed verification)"
+					  << ", reductions: " << LMR_SEARCHES << " (" << LMR_RESEARCHES << " re-searched)\n";
+			TRANSPOSITION_TABLE.Print_Stats();
+			MOVE_ORDERER.Print_Stats();
+		}
+
+		// Check time if that is a factor (the clock may only have started during this iteration,
+		// if the opponent played the move being pondered on)
+		TIME_MANAGER.Check_Ponder_Hit();
+		previous_iteration_ms = last_iteration_ms;
+		last_iteration_ms = TIME_MANAGER.Search_Ms() - iteration_start;
+		if (SEARCH_ABORTED || !TIME_MANAGER.Start_Next_Iteration(last_iteration_ms, previous_iteration_ms))
+		{
+			break;
+		}
+	}
+
+	// This thread has decided on its move, so stop the helpers wherever they are, and clear the
+	// flag again for the next search
+	SEARCH_ABORTED = true;
+	for (int t = 1; t < num_threads; t++)
+	{
+		helpers[t - 1].join();
+		NODE_COUNT += HELPER_NODES[t];
+	}
+	SEARCH_ABORTED = false;
+
+	// A table hit can cut the principal variation short after one move. The expected reply is
+	// then the best move stored for the position after it, if there is a legal one
+	if (action != NULL_MOVE && PONDER_MOVE == NULL_MOVE)
+	{
+		Gamestate after(g);
+		Undo_Record undo;
+		Make_Move(after, action, undo);
+
+		TT_Entry entry;
+		if (TRANSPOSITION_TABLE.Probe(after.hash_key, entry) && Is_Legal_Move(after, entry.best_move))
+		{
+			PONDER_MOVE = entry.best_move;
+		}
+	}
+
+	if (!SEARCH_OPTIONS.uci_output)
+	{
+		if (num_threads > 1)
+		{
+			std::cout << "\t" << num_threads << " threads searched " << NODE_COUNT << " nodes\n";
+		}
+		std::cout << "\tSearched for " << TIME_MANAGER.Elapsed_Ms() << " ms (soft limit " << TIME_MANAGER.soft_limit_ms
+				  << " ms, hard limit " << TIME_MANAGER.hard_limit_ms << " ms)\n";
 	}
 
 	return action;
 }
 
-std::string DL_Minimax_Choice(const Gamestate& g, const int depth_limit)
+void Helper_Search(const Gamestate& g, const int thread_index, const int max_depth)
+{
+	THREAD_INDEX = thread_index;
+	NODE_COUNT = 0;
+
+	// Every other helper starts one ply deeper than the main thread, so at any time the threads
+	// are spread over two depths and do not all search the same tree in the same order
+	int score = 0;
+	for (int depth = 1 + thread_index % 2; depth <= max_depth && !SEARCH_ABORTED; depth++)
+	{
+		Root_Search(g, depth, -INFINITE_SCORE, INFINITE_SCORE, score);
+	}
+
+	HELPER_NODES[thread_index] = NODE_COUNT;
+}
+
+void Poll_Search()
+{
+	// The helpers stop when the main thread does, so they only report their progress. That also
+	// leaves the main thread the only one using the clock, which a ponder hit restarts
+	if (THREAD_INDEX > 0)
+	{
+		HELPER_NODES[THREAD_INDEX].store(NODE_COUNT, std::memory_order_relaxed);
+		return;
+	}
+
+	TIME_MANAGER.Check_Ponder_Hit();
+	if (TIME_MANAGER.Out_Of_Time() || TIME_MANAGER.Out_Of_Nodes(Total_Nodes()))
+	{
+		SEARCH_ABORTED = true;
+	}
+}
+
+uint64_t Total_Nodes()
+{
+	uint64_t nodes = NODE_COUNT;
+	for (int t = 1; t < MAX_SEARCH_THREADS; t++)
+	{
+		nodes += HELPER_NODES[t].load(std::memory_order_relaxed);
+	}
+	return nodes;
+}
+
+void Send_Line(const std::string line)
+{
+	std::lock_guard<std::mutex> lock(OUTPUT_MUTEX);
+	std::cout << line << std::endl;
+}
+
+std::string UCI_Score(const int score)
+{
+	// Mate scores count plies, and UCI counts full moves
+	if (score >= MATE_THRESHOLD)
+	{
+		return "mate " + std::to_string((MATE_SCORE - score + 1) / 2);
+	}
+	if (score <= -MATE_THRESHOLD)
+	{
+		return "mate " + std::to_string(-(MATE_SCORE + score) / 2);
+	}
+	return "cp " + std::to_string(score);
+}
+
+Move DL_Minimax_Choice(const Gamestate& g, const int depth_limit)
+{
+	int best_score = 0;
+	Move best_move = Root_Search(g, depth_limit, -INFINITE_SCORE, INFINITE_SCORE, best_score);
+
+	std::cout << "\tBest move for " << g.next_turn << " is " << Move_to_UCI(best_move) << " (score " << best_score << ")\n";
+
+	// The best move found by minimax up to the depth limit
+	return best_move;
+}
+
+Move Root_Search(const Gamestate& g, const int depth_limit, int alpha, const int beta, int& best_score)
 {
 	// Find all valid moves for the next player in the current state
-	std::vector<std::string> valid_moves = Generate_Player_Moves(g, g.next_turn);
+	Move_List& valid_moves = SEARCH_STACK.plies[0].moves;
+	valid_moves.clear();
+	Generate_Legal_Moves(g, (g.next_turn == 'w' ? WHITE : BLACK), valid_moves);
+	SEARCH_STACK.Clear_PV(0);
+
+	// Try the best move from the last search of this position (usually the previous depth) first
+	TT_Entry entry;
+	Move hash_move = (TRANSPOSITION_TABLE.Probe(g.hash_key, entry) ? entry.best_move : NULL_MOVE);
+	MOVE_ORDERER.Score_Moves(g, valid_moves, hash_move, 0);
 
 	// Check every move to see if it's the best for the player
-	int best_score = (g.next_turn == 'w' ? INT_MIN : INT_MAX);
-	std::string best_move = "";
+	int original_alpha = alpha;
+	best_score = -INFINITE_SCORE;
+	Move best_move = NULL_MOVE;
+
+	// Search on one copy of the state, making and unmaking each move in place
 	Gamestate sim_state(g);
+	Undo_Record& undo = SEARCH_STACK.plies[0].undo;
+
+	NODE_COUNT++;
 
-	std::vector<std::string> ties;
 	for (int i = 0; i < valid_moves.size(); i++)
 	{
-		int new_score = 0;
+		// Bring the most promising remaining move to the front
+		MOVE_ORDERER.Pick_Move(valid_moves, i);
 
-		// Generate the result of the move
-		sim_state = Simulate_Move(g, valid_moves[i]);
+		// Generate the result of the move, and score it from our point of view
+		Make_Move(sim_state, valid_moves[i], undo);
+		int new_score = PV_Search_Child(sim_state, depth_limit, alpha, beta, 1, i == 0);
+		Unmake_Move(sim_state, valid_moves[i], undo);
 
-		// Check if that state has a better value than the previous best
-		if (g.next_turn == 'w')		// White's turn
-		{
-			// If white finds a move with higher value than the last min
- 			new_score = Min_Value(sim_state, depth_limit);
-			if (new_score > best_score || Black_Checkmated(sim_state))		// Check if the next move can checkmate
- 			{
- 				// Update the best
- 				best_score = new_score;
- 				best_move = valid_moves[i];
-
- 				// Clear the ties
- 				ties.clear();
- 			}
- 			else if (new_score == best_score)
- 			{
- 				// Keep track of ties
- 				ties.push_back(valid_moves[i]);
- 			}
-		}
-		else	// Black's turn
+		// The score of an aborted search means nothing. Fall back to the first move searched if
+		// nothing else finished, so there is always a legal move to play
+		if (SEARCH_ABORTED)
 		{
-			// If black finds a move with lower value than the last max
-			new_score = Max_Value(sim_state, depth_limit);
-			if (new_score < best_score || White_Checkmated(sim_state))		// Check if the next move can checkmate
+			if (best_move == NULL_MOVE)
 			{
-				// Update the best
-				best_score = new_score;
 				best_move = valid_moves[i];
-
-				// Clear the ties
-				ties.clear();
 			}
-			else if (new_score == best_score)
+			return best_move;
+		}
+
+		// Only a move that beats every earlier one replaces it, so ties go to the first move searched
+		if (new_score > best_score)
+		{
+			best_score = new_score;
+			best_move = valid_moves[i];
+
+			// Later moves now only need to prove whether they are better than this one
+			if (new_score > alpha)
 			{
-				// Keep track of ties
-				ties.push_back(valid_moves[i]);
+				alpha = new_score;
+				SEARCH_STACK.Update_PV(0, best_move);
+
+				// Beyond the top of the window; the caller will widen it and search again
+				if (alpha >= beta)
+				{
+					break;
+				}
 			}
 		}
 	}
 
-	// If there is no good move (mate is being forced), just take the first move
-	if (best_move == "")
+	// Remember the choice so the position can be recognized later
+	uint8_t bound = EXACT_BOUND;
+	if (best_score >= beta)
 	{
-		best_move = valid_moves[0];
+		bound = LOWER_BOUND;
+	}
+	else if (best_score <= original_alpha)
+	{
+		bound = UPPER_BOUND;
+	}
+	TRANSPOSITION_TABLE.Store(g.hash_key, depth_limit + 1, bound, Score_To_TT(best_score, 0), best_move);
 
-		std::cout << "\tMate forced, picked move " << valid_moves[0] << "\n";
+	return best_move;
+}
+
+int PV_Search_Child(Gamestate& g, const int depth, const int alpha, const int beta, const int ply, const bool first_move, const int reduction)
+{
+	// The first move is expected to be the best, so it needs an exact score
+	if (first_move)
+	{
+		return -Negamax(g, depth, -beta, -alpha, ply);
 	}
-	// Else if there is a tie
-	else if (ties.size() > 1)
+
+	// A move ordered late is probably bad, so a shallower search is usually enough to show it
+	if (reduction > 0)
 	{
-		std::cout << "\tNo best move out of ties: \n\t{ ";
-		for (int i = 0; i < ties.size(); i++)
+		LMR_SEARCHES++;
+		int reduced_score = -Negamax(g, depth - reduction, -alpha - 1, -alpha, ply);
+		if (reduced_score <= alpha || SEARCH_ABORTED)
 		{
-			std::cout << ties[i] << (i < ties.size() - 1 ? ", " : " }\n");
+			return reduced_score;
 		}
-
-		// Get a random one
-		best_move = Get_Random_Move(ties);
+		LMR_RESEARCHES++;
 	}
-	else
+
+	// Every other move only has to be shown to be no better than alpha
+	PVS_SEARCHES++;
+	int score = -Negamax(g, depth, -alpha - 1, -alpha, ply);
+
+	// If it is better after all (and could still be below beta), its exact score is needed
+	if (score > alpha && score < beta && !SEARCH_ABORTED)
 	{
-		std::cout << "\tBest move for " << g.next_turn << " is " << best_move << "\n";
+		PVS_RESEARCHES++;
+		score = -Negamax(g, depth, -beta, -alpha, ply);
 	}
 
-	// The best move found by minimax up to the depth limit
-	return best_move;
+	return score;
 }
 
-float Max_Value(const Gamestate& g, const int depth)
+int Negamax(Gamestate& g, const int depth, int alpha, int beta, const int ply, const bool allow_null_move)
 {
-	// If the gamestate is terminal (end of game)
-	if (Game_Draw(g) || Game_Checkmate(g))
+	// If we hit the depth limit, settle any captures before taking the heuristic score
+	if (depth == 0)
 	{
-		// Return the state's utility value
-		return Utility_Value(g);
+		return Quiescence(g, alpha, beta, ply);
 	}
 
-	// If we hit the depth limit
-	if (depth == 0)
+	NODE_COUNT++;
+	SEARCH_STACK.Clear_PV(ply);
+
+	// Check the clock every so often, and give up once the time (or node budget) is gone
+	if (NODE_COUNT % TIME_CHECK_INTERVAL == 0)
 	{
-		// Return the material score of this state
-		return hValue_Material(g);
+		Poll_Search();
+	}
+	if (SEARCH_ABORTED)
+	{
+		return 0;
 	}
 
-	// Keep searching for the best move
-	// Find all valid moves for white in the current state
-	std::vector<std::string> valid_moves = Generate_Player_Moves(g, 'w');
+	// A position that has come up before is scored as a draw. If repeating it was the best either
+	// player could do the first time, it will be again, so there is no need to wait for the third
+	// time. This has to be checked before the transposition table, whose entries do not know how
+	// the position was reached
+	if (g.Repetition_Count() > 0)
+	{
+		return 0;
+	}
 
-	// Check every move to see if it's the best for the max
-	int best_score = INT_MIN;
-	std::string best_move = "";
-	Gamestate sim_state(g);
+	// Never run off the end of the search stack, however much depth is left
+	if (ply >= MAX_PLY - 1)
+	{
+		return Evaluate(g);
+	}
 
-	for (int i = 0; i < valid_moves.size(); i++)
+	// If this position has already been searched at least this deeply, the stored result may
+	// already settle it. Otherwise its best move is still the most likely to be best again. On
+	// the principal variation (full window) the node is searched anyway, so that its best line
+	// reaches the root instead of stopping at a table entry
+	bool pv_node = (beta - alpha > 1);
+	TT_Entry entry;
+	Move hash_move = NULL_MOVE;
+	bool tt_hit = TRANSPOSITION_TABLE.Probe(g.hash_key, entry);
+	if (tt_hit)
+	{
+		hash_move = entry.best_move;
+	}
+	if (tt_hit && entry.depth >= depth && !pv_node)
+	{
+		int tt_score = Score_From_TT(entry.score, ply);
+
+		if (entry.bound == EXACT_BOUND
+			|| (entry.bound == LOWER_BOUND && tt_score >= beta)
+			|| (entry.bound == UPPER_BOUND && tt_score <= alpha))
+		{
+			return tt_score;
+		}
+	}
+
+	Undo_Record& undo = SEARCH_STACK.plies[ply].undo;
+	int color = (g.next_turn == 'w' ? WHITE : BLACK);
+	bool in_check = Square_Under_Attack(g, g.King_Square(color), g.next_turn);
+
+	// The draws that do not depend on the legal moves end the game here. Checkmate and stalemate
+	// are only known once the moves run out, since they are generated a few at a time below
+	if (Insufficient_Material(g))
+	{
+		return 0;
+	}
+
+	// The fifty-move rule too, except that a checkmate on the move that reached it still counts
+	// (as in Get_Node_Status()), so in check make sure there is a way out first
+	if (g.halfmove_clock >= 100)
+	{
+		if (in_check)
+		{
+			Move_List& evasions = SEARCH_STACK.plies[ply].moves;
+			evasions.clear();
+			Generate_Legal_Moves(g, color, evasions);
+			if (evasions.empty())
+			{
+				return -MATE_SCORE + ply;
+			}
+		}
+		return 0;
+	}
+
+	// Null-move pruning: if the player could pass and still be at or above beta after a shallower
+	// search, a real move would almost always be too. Passing is never allowed in check, and only
+	// outside the principal variation (zero window), where only a bound is needed. With no pieces
+	// but pawns, passing could be the only way out of zugzwang, so it is not tried at all
+	int own_material = Non_Pawn_Material(g, color);
+	if (SEARCH_OPTIONS.null_move_pruning && allow_null_move && !pv_node && !in_check
+		&& depth >= NULL_MOVE_MIN_DEPTH && own_material > 0 && Evaluate(g) >= beta)
 	{
-		// std::cout << "Considering move: " << valid_moves[i] << " at depth " << depth << "\n";
-		int new_score = 0;
+		int reduction = NULL_MOVE_REDUCTION + (depth > 6 ? 1 : 0);
 
-		// Generate the result of the move
-		sim_state = Simulate_Move(g, valid_moves[i]);
+		NULL_MOVE_TRIES++;
+		Make_Null_Move(g, undo);
+		int null_score = -Negamax(g, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+		Unmake_Null_Move(g, undo);
 
-		// If max finds a move with higher value than the last max
-		new_score = Min_Value(sim_state, depth - 1);
+		if (SEARCH_ABORTED)
+		{
+			return 0;
+		}
 
-		// std::cout << "Move " << valid_moves[i] << " has a min score of " << new_score << "\n";
+		if (null_score >= beta)
+		{
+			// A mate found after passing is not a real mate
+			if (null_score >= MATE_THRESHOLD)
+			{
+				null_score = beta;
+			}
+
+			// In endgames where zugzwang is likely, confirm the cutoff with a real (but still
+			// reduced) search where passing is not allowed
+			bool verified = true;
+			if (own_material <= NULL_MOVE_VERIFY_PHASE)
+			{
+				verified = (Negamax(g, depth - reduction, beta - 1, beta, ply, false) >= beta);
+				if (SEARCH_ABORTED)
+				{
+					return 0;
+				}
+			}
+
+			if (verified)
+			{
+				NULL_MOVE_CUTOFFS++;
+				return null_score;
+			}
+			NULL_MOVE_VERIFY_FAILS++;
+		}
+	}
+
+	// Keep searching for the best move. The moves are handed out most promising first, and only
+	// generated as they are needed, since a cutoff often comes before the quiet moves
+	Move_Picker picker(g, MOVE_ORDERER, SEARCH_STACK.plies[ply].moves, hash_move, ply, in_check);
+
+	int original_alpha = alpha;
+	int best_score = -INFINITE_SCORE;
+	Move best_move = NULL_MOVE;
+
+	int i = 0;
+	for (Move m = picker.Next_Move(); m != NULL_MOVE; m = picker.Next_Move(), i++)
+	{
+		// Make the move in place
+		Make_Move(g, m, undo);
+
+		// Late move reductions: quiet moves ordered after the hash move, captures, and the first
+		// few others rarely turn out best, so search them shallower unless they are killers,
+		// escape check, or give check
+		int reduction = 0;
+		if (SEARCH_OPTIONS.late_move_reductions && i >= LMR_MIN_MOVES && depth >= LMR_MIN_DEPTH
+			&& !in_check && !Is_Capture(m) && !Is_Promotion(m)
+			&& m != MOVE_ORDERER.killers[ply][0] && m != MOVE_ORDERER.killers[ply][1]
+			&& !Square_Under_Attack(g, g.King_Square(1 - color), g.next_turn))
+		{
+			reduction = (i >= 2 * LMR_MIN_MOVES && depth >= 2 * LMR_MIN_DEPTH ? 2 : 1);
+		}
+
+		// Score it from our point of view
+		int new_score = PV_Search_Child(g, depth - 1, alpha, beta, ply + 1, i == 0, reduction);
+		Unmake_Move(g, m, undo);
+
+		// Nothing learned from an aborted search can be trusted, so do not store it
+		if (SEARCH_ABORTED)
+		{
+			return 0;
+		}
 
 		if (new_score > best_score)
 		{
-			// Update the best
 			best_score = new_score;
-			best_move = valid_moves[i];
+			best_move = m;
+
+			if (new_score > alpha)
+			{
+				alpha = new_score;
+				SEARCH_STACK.Update_PV(ply, best_move);
+
+				// The opponent already has a better option earlier in the tree, so they will never
+				// let the game reach this position. The remaining moves do not need to be searched
+				if (alpha >= beta)
+				{
+					MOVE_ORDERER.Update_Cutoff(g, best_move, depth, ply, i);
+					break;
+				}
+			}
 		}
 	}
 
-	// std::cout << "The maximum min score is " << best_score << "\n";
+	// With no legal moves, the game is over: checkmate if in check, stalemate otherwise
+	if (best_move == NULL_MOVE)
+	{
+		return (in_check ? -MATE_SCORE + ply : 0);
+	}
+
+	// Save the result so transpositions of this position do not need to be searched again.
+	// A cutoff only proves a lower bound, and failing to beat alpha only proves an upper bound
+	uint8_t bound = EXACT_BOUND;
+	if (best_score >= beta)
+	{
+		bound = LOWER_BOUND;
+	}
+	else if (best_score <= original_alpha)
+	{
+		bound = UPPER_BOUND;
+	}
+	TRANSPOSITION_TABLE.Store(g.hash_key, depth, bound, Score_To_TT(best_score, ply), best_move);
 
-	// The best score for max at this depth
 	return best_score;
 }
 
-float Min_Value(const Gamestate& g, const int depth)
+int Non_Pawn_Material(const Gamestate& g, const int color)
 {
-	// If the gamestate is terminal (end of game)
-	if (Game_Draw(g) || Game_Checkmate(g))
+	int material = 0;
+	for (int type = KNIGHT; type < KING; type++)
 	{
-		// Return the state's utility value
-		return Utility_Value(g);
+		material += Pop_Count(g.pieces[color][type]) * PHASE_WEIGHTS[type];
 	}
+	return material;
+}
 
-	// If we hit the depth limit
-	if (depth == 0)
+int Quiescence(Gamestate& g, int alpha, int beta, const int ply)
+{
+	NODE_COUNT++;
+
+	// Lines through captures are not kept, so the best line ends at the last full-width move
+	SEARCH_STACK.Clear_PV(ply);
+
+	// Check the clock every so often, and give up once the time (or node budget) is gone
+	if (NODE_COUNT % TIME_CHECK_INTERVAL == 0)
+	{
+		Poll_Search();
+	}
+	if (SEARCH_ABORTED)
+	{
+		return 0;
+	}
+
+	// Score draws the same way Negamax() does. Check evasions are quiet moves, so a line can
+	// repeat here too, and any repetition has to count the same wherever it is reached. The
+	// fifty-move rule is checked once the moves are known, since checkmate comes first
+	if (g.Repetition_Count() > 0 || Insufficient_Material(g))
 	{
-		// Return the material score of this state
-		return hValue_Material(g);
+		return 0;
 	}
 
-	// Keep searching for the best move
-	// Find all valid moves for white in the current state
-	std::vector<std::string> valid_moves = Generate_Player_Moves(g, 'b');
+	// Stop somewhere, even in a very long exchange
+	if (ply >= MAX_PLY - 1)
+	{
+		return Evaluate(g);
+	}
 
-	// Check every move to see if it's the best for the min
-	int best_score = INT_MAX;
-	std::string best_move = "";
-	Gamestate sim_state(g);
+	// Only captures and promotions, or every move if in check
+	Move_List& moves = SEARCH_STACK.plies[ply].moves;
+	moves.clear();
+	bool in_check = (Generate_Legal_Moves(g, (g.next_turn == 'w' ? WHITE : BLACK), moves, GEN_CAPTURES) != 0);
 
-	for (int i = 0; i < valid_moves.size(); i++)
+	if (g.halfmove_clock >= 100 && !(in_check && moves.empty()))
+	{
+		return 0;
+	}
+
+	int best_score = -INFINITE_SCORE;
+	int stand_pat = 0;
+	if (in_check)
+	{
+		// With every move out of check generated, having none is checkmate
+		if (moves.empty())
+		{
+			return -MATE_SCORE + ply;
+		}
+	}
+	else
 	{
+		// The player can decline every capture, so the position is worth at least its heuristic score
+		stand_pat = Evaluate(g);
+		best_score = stand_pat;
+		if (stand_pat >= beta)
+		{
+			return stand_pat;
+		}
+		if (stand_pat > alpha)
+		{
+			alpha = stand_pat;
+		}
+	}
+
+	// Try the biggest captures first (no hash move or killers are used here)
+	MOVE_ORDERER.Score_Moves(g, moves, NULL_MOVE, ply);
+	Undo_Record& undo = SEARCH_STACK.plies[ply].undo;
+
+	for (int i = 0; i < moves.size(); i++)
+	{
+		MOVE_ORDERER.Pick_Move(moves, i);
+		Move m = moves[i];
+
+		// Delta pruning: skip captures that cannot raise the score to alpha even with a margin
+		// for the positional change. Promotions can swing the score too much to be skipped
+		if (!in_check && !Is_Promotion(m))
+		{
+			int victim = (Move_Flags(m) == EP_CAPTURE ? PAWN : Piece_Type(g.board[Move_To(m)]));
+			if (stand_pat + MG_PIECE_VALUES[victim] + DELTA_MARGIN <= alpha)
+			{
+				continue;
+			}
+		}
+
+		Make_Move(g, m, undo);
+		int new_score = -Quiescence(g, -beta, -alpha, ply + 1);
+		Unmake_Move(g, m, undo);
+
+		if (SEARCH_ABORTED)
+		{
+			return 0;
+		}
 
-		// std::cout << "Considering move: " << valid_moves[i] << " at depth " << depth << "\n";
-		int new_score = 0;
+		if (new_score > best_score)
+		{
+			best_score = new_score;
+			if (new_score > alpha)
+			{
+				alpha = new_score;
+				if (alpha >= beta)
+				{
+					break;
+				}
+			}
+		}
+	}
 
-		// Generate the result of the move
-		sim_state = Simulate_Move(g, valid_moves[i]);
+	return best_score;
+}
 
-		// If min finds a move with lower value than the last min
-		new_score = Max_Value(sim_state, depth - 1);
+Move Full_Minimax_Choice(const Gamestate& g, const int depth_limit, int& best_score)
+{
+	Move_List valid_moves = Generate_Player_Moves(g, g.next_turn);
 
-		// std::cout << "Move " << valid_moves[i] << " has a max score of " << new_score << "\n";
+	best_score = -INFINITE_SCORE;
+	Move best_move = NULL_MOVE;
 
+	Gamestate sim_state(g);
+	Undo_Record undo;
 
+	NODE_COUNT++;
 
-		if (new_score < best_score)
+	for (int i = 0; i < valid_moves.size(); i++)
+	{
+		Make_Move(sim_state, valid_moves[i], undo);
+		int new_score = -Full_Minimax(sim_state, depth_limit, 1);
+		Unmake_Move(sim_state, valid_moves[i], undo);
+
+		if (new_score > best_score)
 		{
-			// Update the best
 			best_score = new_score;
 			best_move = valid_moves[i];
 		}
 	}
 
-	// std::cout << "The minimum max score is " << best_score << "\n";
+	return best_move;
+}
+
+int Full_Minimax(Gamestate& g, const int depth, const int ply)
+{
+	// Same depth limit and terminal checks as Negamax()
+	if (depth == 0)
+	{
+		// Quiescence with a full window gives the exact value of the capture sequence
+		return Quiescence(g, -INFINITE_SCORE, INFINITE_SCORE, ply);
+	}
+
+	NODE_COUNT++;
+
+	Node_Status status;
+	Get_Node_Status(g, status);
+	if (status.Is_Draw())
+	{
+		return 0;
+	}
+	if (status.checkmate)
+	{
+		return -MATE_SCORE + ply;
+	}
+
+	// Search every move, with no pruning
+	Move_List& valid_moves = status.valid_moves;
+
+	int best_score = -INFINITE_SCORE;
+	Undo_Record undo;
+
+	for (int i = 0; i < valid_moves.size(); i++)
+	{
+		Make_Move(g, valid_moves[i], undo);
+		int new_score = -Full_Minimax(g, depth - 1, ply + 1);
+		Unmake_Move(g, valid_moves[i], undo);
+
+		if (new_score > best_score)
+		{
+			best_score = new_score;
+		}
+	}
 
-	// The best score for min at this depth
 	return best_score;
 }
 
@@ -295,24 +1049,52 @@ int hValue_Material(const Gamestate& g)
 	int white_mat = 0;
 	int black_mat = 0;
 
-	// Iterate over every square
-	for (int i = 0; i < g.board.size(); i++)
+	// Count each piece type for both colors, and weigh the counts according to the table
+	for (int type = PAWN; type < KING; type++)
 	{
-		// If it's a white piece
-		if (isupper(g.board[i]))
-		{
-			// Increment the white material according to the table
-			white_mat += MATERIAL_VALS.at(g.board[i]);
-		}
-		// If it's a black piece
-		else if (islower(g.board[i]))
-		{
-			// Increment black material
-			black_mat += MATERIAL_VALS.at(g.board[i]);
-		}
+		white_mat += Pop_Count(g.pieces[WHITE][type]) * MATERIAL_VALS[type];
+		black_mat += Pop_Count(g.pieces[BLACK][type]) * MATERIAL_VALS[type];
 	}
 
 	return white_mat - black_mat;
 }
 
+int Evaluate(const Gamestate& g)
+{
+	// Weigh the middlegame score by how much material is left, and the endgame score by how
+	// much is gone. Promotions can push the phase past the start, so cap it there
+	int phase = (g.phase < MAX_PHASE ? g.phase : MAX_PHASE);
+	int score = (g.mg_score * phase + g.eg_score * (MAX_PHASE - phase)) / MAX_PHASE;
+
+	// The scores are from white's point of view
+	return (g.next_turn == 'w' ? score : -score);
+}
+
+int Score_To_TT(const int score, const int ply)
+{
+	// Mates are stored as the distance from this position rather than from the root
+	if (score > MATE_THRESHOLD)
+	{
+		return score + ply;
+	}
+	if (score < -MATE_THRESHOLD)
+	{
+		return score - ply;
+	}
+	return score;
+}
+
+int Score_From_TT(const int score, const int ply)
+{
+	if (score > MATE_THRESHOLD)
+	{
+		return score - ply;
+	}
+	if (score < -MATE_THRESHOLD)
+	{
+		return score + ply;
+	}
+	return score;
+}
+
 #endif
\ No newline at end of file
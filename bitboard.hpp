@@ -0,0 +1,439 @@
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <cstdint> // uint64_t
+
+// When compiled for a CPU with BMI2 (ex. -mbmi2 or -march=native), slider attack lookups use the
+// PEXT instruction to index the tables; otherwise they use a multiply and shift by a magic number
+#ifdef __BMI2__
+#include <immintrin.h> // _pext_u64
+#endif
+
+
+// A bitboard is a 64-bit mask with one bit per square. Bit 0 is a1, bit 7 is h1,
+// and bit 63 is h8, which matches the square indexing used by Gamestate::board
+typedef uint64_t Bitboard;
+
+// Color indices used to address the bitboard arrays
+const int WHITE = 0;
+const int BLACK = 1;
+
+// Piece type indices used to address the bitboard arrays
+const int PAWN = 0;
+const int KNIGHT = 1;
+const int BISHOP = 2;
+const int ROOK = 3;
+const int QUEEN = 4;
+const int KING = 5;
+const int NO_PIECE_TYPE = 6;
+
+// Character used for each piece type, indexed [color][type]
+const char PIECE_CHARS[2][6] =
+{
+	{'P', 'N', 'B', 'R', 'Q', 'K'},
+	{'p', 'n', 'b', 'r', 'q', 'k'}
+};
+
+// Useful file and rank masks
+const Bitboard FILE_A = 0x0101010101010101ULL;
+const Bitboard FILE_H = 0x8080808080808080ULL;
+const Bitboard RANK_1 = 0x00000000000000FFULL;
+const Bitboard RANK_2 = 0x000000000000FF00ULL;
+const Bitboard RANK_4 = 0x00000000FF000000ULL;
+const Bitboard RANK_5 = 0x000000FF00000000ULL;
+const Bitboard RANK_7 = 0x00FF000000000000ULL;
+const Bitboard RANK_8 = 0xFF00000000000000ULL;
+
+// Every dark square (a1, c1, ..., h8)
+const Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+
+// Ray directions, in the order used by RAYS. The first four point towards higher
+// square indices, the last four towards lower ones
+const int RAY_N = 0;
+const int RAY_NE = 1;
+const int RAY_E = 2;
+const int RAY_NW = 3;
+const int RAY_S = 4;
+const int RAY_SW = 5;
+const int RAY_W = 6;
+const int RAY_SE = 7;
+
+
+//////// Attack Tables ////////
+
+// Squares attacked by a knight/king standing on each square
+Bitboard KNIGHT_ATTACKS[64];
+Bitboard KING_ATTACKS[64];
+
+// Squares attacked by a pawn of each color standing on each square, indexed [color][square]
+Bitboard PAWN_ATTACKS[2][64];
+
+// Every square along a direction from each square up to the edge of the board,
+// indexed [direction][square]
+Bitboard RAYS[8][64];
+
+// Squares strictly between two squares that share a rank, file, or diagonal (empty otherwise),
+// indexed [square][square]
+Bitboard BETWEEN[64][64];
+
+// The whole rank, file, or diagonal through two squares, including both (empty if they are not
+// aligned), indexed [square][square]
+Bitboard LINE[64][64];
+
+
+//////// Magic Bitboards ////////
+
+// A slider's attacks only depend on the pieces along its rays, not counting the last square
+// before the edge (a piece there blocks nothing further). Those squares form the "mask". The
+// occupied squares within the mask are turned into a table index, either with PEXT (packing the
+// masked bits together) or by multiplying by a "magic" number that gathers those bits into the
+// top of the product without any two occupancies with different attacks landing on the same index
+class Magic
+{
+public:
+	Bitboard mask;		// relevant blocker squares
+	Bitboard magic;		// multiplier for the magic index
+	int shift;			// 64 - number of bits in the mask
+	int offset;			// where this square's attacks start in the attack table
+};
+
+Magic ROOK_MAGICS[64];
+Magic BISHOP_MAGICS[64];
+
+// Attack sets for every relevant occupancy of every square, in blocks indexed by Magic::offset
+Bitboard ROOK_ATTACK_TABLE[102400];
+Bitboard BISHOP_ATTACK_TABLE[5248];
+
+// Magic multipliers, found ahead of time by random search so startup only has to fill the tables
+const Bitboard ROOK_MAGIC_NUMBERS[64] =
+{
+	0x3080004000802010ULL, 0x0C40029005C02004ULL, 0x4080100259200080ULL, 0x1100042009021000ULL,
+	0x2100030010080004ULL, 0x1200860044001810ULL, 0x0400080110008402ULL, 0x2200008040240102ULL,
+	0x0000800020804004ULL, 0x0184804000200480ULL, 0x0848801004200080ULL, 0x1001001001002008ULL,
+	0x8001000408001100ULL, 0x0101000802040100ULL, 0x4285001401000200ULL, 0x008180010020C080ULL,
+	0x0000228000400080ULL, 0x0810004000402000ULL, 0x0010008020008018ULL, 0x1400090021021000ULL,
+	0x820A808004000802ULL, 0x0404008002008004ULL, 0x0202008080020100ULL, 0x094402000C025181ULL,
+	0x0280400080008020ULL, 0x0200200040401000ULL, 0x0404482200108200ULL, 0x00081022000A0040ULL,
+	0x1000040080800800ULL, 0x0182000200058810ULL, 0x0000827400481021ULL, 0x0000008200091064ULL,
+	0x0040004020800089ULL, 0x648E024102002082ULL, 0x0000200080801000ULL, 0x001200419200200AULL,
+	0x0430080080800400ULL, 0x0000040080800200ULL, 0x002201100400D802ULL, 0x5800404082000401ULL,
+	0x0000400080008020ULL, 0x0140028020018044ULL, 0x4004801204420020ULL, 0x080210030021000AULL,
+	0x2204000408008080ULL, 0x020A000804020010ULL, 0x0100010002008080ULL, 0x2000440040820001ULL,
+	0x0000408000210100ULL, 0x4000810028420200ULL, 0x0A8020010043B100ULL, 0x0100201000090100ULL,
+	0x0001021048004500ULL, 0x0002020080040080ULL, 0x0048080102100400ULL, 0x00410000A2084100ULL,
+	0x0040110222004682ULL, 0x0802002100408012ULL, 0x0420040820401101ULL, 0x8040200805001001ULL,
+	0x0045000218001035ULL, 0x840A001001080482ULL, 0x0800420081300804ULL, 0x0400008100402412ULL
+};
+
+const Bitboard BISHOP_MAGIC_NUMBERS[64] =
+{
+	0x0002200800808083ULL, 0x082401020E120004ULL, 0x001000A208400000ULL, 0x4024052600949040ULL,
+	0x0002021100000101ULL, 0x00220802080C0000ULL, 0x000C014108210908ULL, 0x024A049080901001ULL,
+	0x0043C20411020210ULL, 0x002020213A248100ULL, 0x09224942040D0183ULL, 0x01000C4220802000ULL,
+	0x0041820211000400ULL, 0x3000320802080800ULL, 0x030084010402A000ULL, 0x0210004C04040200ULL,
+	0x0010014430220820ULL, 0x0002042008010904ULL, 0x08A0403008404040ULL, 0x0260202202004000ULL,
+	0x2004005211200800ULL, 0x08048060C8044000ULL, 0x004B003209012040ULL, 0x0460802042009004ULL,
+	0x2002080EC0110440ULL, 0x0018022004948800ULL, 0x0008404008060040ULL, 0x1821080001004300ULL,
+	0x0001020044008401ULL, 0x4010004040241008ULL, 0x0004040000A08404ULL, 0x000CB10082004200ULL,
+	0x6001100800112000ULL, 0x06181110A4148400ULL, 0x0004002480480204ULL, 0x1200400808608200ULL,
+	0x00A8020400001010ULL, 0xC220040020010090ULL, 0x00018A0080440C10ULL, 0x8002020040002401ULL,
+	0x180101109030C040ULL, 0x8010884108801000ULL, 0x0013420050048100ULL, 0x010021A018008101ULL,
+	0x8040080904440401ULL, 0x1042240804200A00ULL, 0x404802E082018400ULL, 0x0010008200480089ULL,
+	0x0004008404201228ULL, 0x090042280402000AULL, 0x0248108888210800ULL, 0x0005800E05042404ULL,
+	0x08000808A1010030ULL, 0x0208A02202060A10ULL, 0x00C0481901461048ULL, 0x00221042418104A0ULL,
+	0x88084400808820C2ULL, 0x0000408448421040ULL, 0x0880200242009038ULL, 0x0C41020080208800ULL,
+	0x0000880520A24410ULL, 0x00001041C4080A21ULL, 0x0000295810108200ULL, 0x0011201A00460020ULL
+};
+
+
+//////// Function Declarations ////////
+
+// Fill in the attack tables the first time it is called
+void Init_Bitboards();
+
+// Get the bitboard with only the given square set
+inline Bitboard Square_BB(const int index);
+
+// Count the number of set bits
+inline int Pop_Count(const Bitboard b);
+
+// Get the index of the least/most significant set bit (b must not be empty)
+inline int LSB(const Bitboard b);
+inline int MSB(const Bitboard b);
+
+// Get the index of the least significant set bit, then clear it from the bitboard
+inline int Pop_LSB(Bitboard& b);
+
+// Get the color index (WHITE/BLACK) of a piece character
+inline int Piece_Color(const char piece);
+
+// Get the type index (PAWN-KING) of a piece character, or NO_PIECE_TYPE for an empty square
+inline int Piece_Type(const char piece);
+
+// Get the squares attacked along one ray, stopping at (and including) the first blocker
+inline Bitboard Ray_Attacks(const int dir, const int index, const Bitboard occupied);
+
+// Get the squares attacked by a bishop/rook by walking each of its rays. Only used to fill in
+// the magic attack tables
+Bitboard Ray_Bishop_Attacks(const int index, const Bitboard occupied);
+Bitboard Ray_Rook_Attacks(const int index, const Bitboard occupied);
+
+// Fill in the magic masks and attack tables for one kind of slider
+void Init_Magics(Magic magics[64], Bitboard attack_table[], const Bitboard magic_numbers[64], const bool is_rook);
+
+// Get the attack table index for the given occupancy
+inline int Magic_Index(const Magic& m, const Bitboard occupied);
+
+// Get the squares attacked by a bishop/rook/queen on the given square
+inline Bitboard Bishop_Attacks(const int index, const Bitboard occupied);
+inline Bitboard Rook_Attacks(const int index, const Bitboard occupied);
+inline Bitboard Queen_Attacks(const int index, const Bitboard occupied);
+
+
+//////// Function Implementations ////////
+
+void Init_Bitboards()
+{
+	// A function-local static is initialized exactly once, even when several threads construct
+	// their first Gamestate at the same time, and the others wait until it is done
+	static const bool initialized = []
+	{
+		// File and rank steps for each ray direction, in RAY_* order
+		const int ray_steps[8][2] = {{0, 1}, {1, 1}, {1, 0}, {-1, 1}, {0, -1}, {-1, -1}, {-1, 0}, {1, -1}};
+
+		// File and rank steps for every knight and king move
+		const int knight_steps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+		const int king_steps[8][2] = {{0, 1}, {1, 1}, {1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}};
+
+		for (int sq = 0; sq < 64; sq++)
+		{
+			int file = sq % 8;
+			int rank = sq / 8;
+
+			KNIGHT_ATTACKS[sq] = 0;
+			KING_ATTACKS[sq] = 0;
+			PAWN_ATTACKS[WHITE][sq] = 0;
+			PAWN_ATTACKS[BLACK][sq] = 0;
+
+			// Single-step pieces only need to check that the destination is on the board
+			for (int i = 0; i < 8; i++)
+			{
+				int f = file + knight_steps[i][0];
+				int r = rank + knight_steps[i][1];
+				if (f >= 0 && f < 8 && r >= 0 && r < 8)
+				{
+					KNIGHT_ATTACKS[sq] |= Square_BB(r * 8 + f);
+				}
+
+				f = file + king_steps[i][0];
+				r = rank + king_steps[i][1];
+				if (f >= 0 && f < 8 && r >= 0 && r < 8)
+				{
+					KING_ATTACKS[sq] |= Square_BB(r * 8 + f);
+				}
+			}
+
+			// Pawns attack diagonally forward
+			for (int df = -1; df <= 1; df += 2)
+			{
+				int f = file + df;
+				if (f < 0 || f > 7)
+				{
+					continue;
+				}
+				if (rank < 7)
+				{
+					PAWN_ATTACKS[WHITE][sq] |= Square_BB((rank + 1) * 8 + f);
+				}
+				if (rank > 0)
+				{
+					PAWN_ATTACKS[BLACK][sq] |= Square_BB((rank - 1) * 8 + f);
+				}
+			}
+
+			// Rays keep stepping until they leave the board
+			for (int dir = 0; dir < 8; dir++)
+			{
+				RAYS[dir][sq] = 0;
+
+				int f = file + ray_steps[dir][0];
+				int r = rank + ray_steps[dir][1];
+				while (f >= 0 && f < 8 && r >= 0 && r < 8)
+				{
+					RAYS[dir][sq] |= Square_BB(r * 8 + f);
+					f += ray_steps[dir][0];
+					r += ray_steps[dir][1];
+				}
+			}
+		}
+
+		// Squares along a ray are aligned with the start square. The opposite direction of each ray
+		// is 4 directions later in the RAY_* order (ex. RAY_N and RAY_S)
+		for (int a = 0; a < 64; a++)
+		{
+			for (int b = 0; b < 64; b++)
+			{
+				BETWEEN[a][b] = 0;
+				LINE[a][b] = 0;
+			}
+
+			for (int dir = 0; dir < 8; dir++)
+			{
+				Bitboard ray = RAYS[dir][a];
+				while (ray)
+				{
+					int b = Pop_LSB(ray);
+					BETWEEN[a][b] = RAYS[dir][a] & ~RAYS[dir][b] & ~Square_BB(b);
+					LINE[a][b] = RAYS[dir][a] | RAYS[dir ^ 4][a] | Square_BB(a);
+				}
+			}
+		}
+
+		// The slider tables are built from the rays
+		Init_Magics(ROOK_MAGICS, ROOK_ATTACK_TABLE, ROOK_MAGIC_NUMBERS, true);
+		Init_Magics(BISHOP_MAGICS, BISHOP_ATTACK_TABLE, BISHOP_MAGIC_NUMBERS, false);
+
+		return true;
+	}();
+	(void)initialized;
+}
+
+void Init_Magics(Magic magics[64], Bitboard attack_table[], const Bitboard magic_numbers[64], const bool is_rook)
+{
+	int offset = 0;
+
+	for (int sq = 0; sq < 64; sq++)
+	{
+		Magic& m = magics[sq];
+
+		// Squares on the edge of the board never block anything behind them, so leave them out
+		// of the mask. For rooks only the edge at the end of each ray matters, since a rook on an
+		// edge still needs the rest of that edge in its mask
+		if (is_rook)
+		{
+			m.mask = (RAYS[RAY_N][sq] & ~RANK_8) | (RAYS[RAY_S][sq] & ~RANK_1)
+				   | (RAYS[RAY_E][sq] & ~FILE_H) | (RAYS[RAY_W][sq] & ~FILE_A);
+		}
+		else
+		{
+			m.mask = (RAYS[RAY_NE][sq] | RAYS[RAY_NW][sq] | RAYS[RAY_SE][sq] | RAYS[RAY_SW][sq])
+				   & ~(RANK_1 | RANK_8 | FILE_A | FILE_H);
+		}
+
+		m.magic = magic_numbers[sq];
+		m.shift = 64 - Pop_Count(m.mask);
+		m.offset = offset;
+
+		// Visit every subset of the mask (Carry-Rippler trick) and store its attacks
+		Bitboard occupied = 0;
+		do
+		{
+			attack_table[offset + Magic_Index(m, occupied)] = (is_rook ? Ray_Rook_Attacks(sq, occupied) : Ray_Bishop_Attacks(sq, occupied));
+			occupied = (occupied - m.mask) & m.mask;
+		} while (occupied);
+
+		offset += 1 << Pop_Count(m.mask);
+	}
+}
+
+inline Bitboard Square_BB(const int index)
+{
+	return 1ULL << index;
+}
+
+inline int Pop_Count(const Bitboard b)
+{
+	return __builtin_popcountll(b);
+}
+
+inline int LSB(const Bitboard b)
+{
+	return __builtin_ctzll(b);
+}
+
+inline int MSB(const Bitboard b)
+{
+	return 63 - __builtin_clzll(b);
+}
+
+inline int Pop_LSB(Bitboard& b)
+{
+	int index = LSB(b);
+	b &= b - 1;
+	return index;
+}
+
+inline int Piece_Color(const char piece)
+{
+	return (piece >= 'a' ? BLACK : WHITE);
+}
+
+inline int Piece_Type(const char piece)
+{
+	switch (piece)
+	{
+		case 'P': case 'p': return PAWN;
+		case 'N': case 'n': return KNIGHT;
+		case 'B': case 'b': return BISHOP;
+		case 'R': case 'r': return ROOK;
+		case 'Q': case 'q': return QUEEN;
+		case 'K': case 'k': return KING;
+		default: return NO_PIECE_TYPE;
+	}
+}
+
+inline Bitboard Ray_Attacks(const int dir, const int index, const Bitboard occupied)
+{
+	Bitboard attacks = RAYS[dir][index];
+	Bitboard blockers = attacks & occupied;
+
+	// If something is in the way, cut the ray off behind the nearest blocker
+	if (blockers)
+	{
+		// Directions 0-3 move towards higher indices, so the nearest blocker is the lowest bit
+		int blocker = (dir < 4 ? LSB(blockers) : MSB(blockers));
+		attacks ^= RAYS[dir][blocker];
+	}
+
+	return attacks;
+}
+
+Bitboard Ray_Bishop_Attacks(const int index, const Bitboard occupied)
+{
+	return Ray_Attacks(RAY_NE, index, occupied) | Ray_Attacks(RAY_NW, index, occupied)
+		 | Ray_Attacks(RAY_SE, index, occupied) | Ray_Attacks(RAY_SW, index, occupied);
+}
+
+Bitboard Ray_Rook_Attacks(const int index, const Bitboard occupied)
+{
+	return Ray_Attacks(RAY_N, index, occupied) | Ray_Attacks(RAY_E, index, occupied)
+		 | Ray_Attacks(RAY_S, index, occupied) | Ray_Attacks(RAY_W, index, occupied);
+}
+
+inline int Magic_Index(const Magic& m, const Bitboard occupied)
+{
+#ifdef __BMI2__
+	return int(_pext_u64(occupied, m.mask));
+#else
+	return int(((occupied & m.mask) * m.magic) >> m.shift);
+#endif
+}
+
+inline Bitboard Bishop_Attacks(const int index, const Bitboard occupied)
+{
+	const Magic& m = BISHOP_MAGICS[index];
+	return BISHOP_ATTACK_TABLE[m.offset + Magic_Index(m, occupied)];
+}
+
+inline Bitboard Rook_Attacks(const int index, const Bitboard occupied)
+{
+	const Magic& m = ROOK_MAGICS[index];
+	return ROOK_ATTACK_TABLE[m.offset + Magic_Index(m, occupied)];
+}
+
+inline Bitboard Queen_Attacks(const int index, const Bitboard occupied)
+{
+	return Bishop_Attacks(index, occupied) | Rook_Attacks(index, occupied);
+}
+
+#endif
@@ -2,8 +2,7 @@
 #define GAME_LOGIC_HPP
 
 #include "gamestate.hpp"
-
-#include <vector>
+#include "move.hpp"
 
 #include <cstdlib> // isupper, islower, rand
 #include <ctime> // time
@@ -27,6 +26,43 @@ const int SE = -7;
 const int S = -8;
 const int SW = -9;
 
+// Which moves the generator produces. Promotions are counted along with the captures, since they
+// change the material balance just as much. When in check, GEN_CAPTURES produces every evasion
+const int GEN_ALL = 0;
+const int GEN_CAPTURES = 1;
+const int GEN_QUIETS = 2;
+
+
+// Everything Make_Move() overwrites that cannot be worked out again from the move itself
+class Undo_Record
+{
+public:
+	char captured;				// piece that was captured, or ' ' if none
+	int castling_rights;		// castles available before the move
+	int en_passant_square;		// en passant target before the move
+	int halfmove_clock;			// halfmove clock before the move
+	uint64_t hash_key;			// Zobrist key before the move
+};
+
+// Everything the search needs to know about a position before looking at its moves, worked out
+// with a single move generation by Get_Node_Status()
+class Node_Status
+{
+public:
+	Move_List valid_moves;				// every legal move for the player to move
+	bool in_check;						// the player to move is in check
+	bool checkmate;						// in check with no legal moves
+	bool stalemate;						// not in check, but no legal moves
+	bool draw_conditions;				// fifty-move rule or threefold repetition
+	bool insufficient_material;			// neither player can checkmate
+
+	// Check if the game is drawn by any rule
+	bool Is_Draw() const
+	{
+		return draw_conditions || stalemate || insufficient_material;
+	}
+};
+
 
 //////// Function Declarations ////////
 
@@ -36,43 +72,102 @@ std::string Convert_to_Algebraic(const int index);
 // Convert the given algebraic square (a1-h8) into its equivalent index (0-63)
 int Convert_to_Index(const std::string square);
 
-// Given some game state, generate all valid moves for the current player color
-std::vector<std::string> Generate_Player_Moves(const Gamestate& g, const char player_color);
+// Append a move from the given square to every square set in "targets", flagging captures
+void Add_Target_Moves(Move_List& moves, const Gamestate& g, const int index, Bitboard targets);
+
+// Same as Add_Target_Moves() for a pawn, expanding moves onto the last rank into every promotion
+void Add_Pawn_Target_Moves(Move_List& moves, const Gamestate& g, const int index, Bitboard targets);
+
+// Append the castling moves available to the king on the given square
+void Add_Castling_Moves(Move_List& moves, const Gamestate& g, const int index);
+
+// Get the set of squares attacked by the piece on the given square
+Bitboard Piece_Attacks(const Gamestate& g, const int index);
+
+// Get the pieces of the given color that are the only piece between their king and an enemy
+// slider, and so can only move along that line
+Bitboard Pinned_Pieces(const Gamestate& g, const int color);
+
+// Given some game state, generate all valid moves for the current player color. Only legal moves
+// are generated, using the pinned pieces and the pieces giving check to restrict each piece's targets.
+// The list is returned by value, but lives entirely on the stack
+Move_List Generate_Player_Moves(const Gamestate& g, const char player_color);
+
+// Same as Generate_Player_Moves(), but appending the moves to "valid_moves" and returning the
+// enemy pieces giving check, which the generator has to find anyway. "gen_type" picks which moves
+// are generated (see GEN_ALL), and only pieces standing on "sources" are moved
+Bitboard Generate_Legal_Moves(const Gamestate& g, const int color, Move_List& valid_moves, const int gen_type = GEN_ALL, const Bitboard sources = ~Bitboard(0));
 
-// Generate all possible pawn moves from the current square. When "ignore_non_attacks" == true,
-// straight-line and en passant pawn moves are not returned.
-std::vector<std::string> Generate_Pawn_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks);
+// Check if the given move is legal in the current position
+bool Is_Legal_Move(const Gamestate& g, const Move move);
 
-// Generate all possible bishop moves from the current square
-std::vector<std::string> Generate_Bishop_Moves(const Gamestate& g, const int index);
+// Add all possible pawn moves from the current square to "moves". When "ignore_non_attacks" == true,
+// straight-line and en passant pawn moves are not added
+void Generate_Pawn_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves);
 
-// Generate all possible rook moves from the current square
-std::vector<std::string> Generate_Rook_Moves(const Gamestate& g, const int index);
+// Add all possible bishop moves from the current square to "moves"
+void Generate_Bishop_Moves(const Gamestate& g, const int index, Move_List& moves);
 
-// Generate all possible knight moves from the current square
-std::vector<std::string> Generate_Knight_Moves(const Gamestate& g, const int index);
+// Add all possible rook moves from the current square to "moves"
+void Generate_Rook_Moves(const Gamestate& g, const int index, Move_List& moves);
 
-// Generate all possible queen moves from the current square
-std::vector<std::string> Generate_Queen_Moves(const Gamestate& g, const int index);
+// Add all possible knight moves from the current square to "moves"
+void Generate_Knight_Moves(const Gamestate& g, const int index, Move_List& moves);
 
-// Generate all possible king moves from the current square. When "ignore_non_attacks" == true,
-// the possible castling moves are not returned
-std::vector<std::string> Generate_King_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks);
+// Add all possible queen moves from the current square to "moves"
+void Generate_Queen_Moves(const Gamestate& g, const int index, Move_List& moves);
+
+// Add all possible king moves from the current square to "moves". When "ignore_non_attacks" == true,
+// the possible castling moves are not added
+void Generate_King_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves);
 
 // Given some gamestate, and a square index that contains a piece, determine every possible
-// move that piece can make. When "ignore_non_attacks" == true, straight-line pawn moves, en passant,
-// and castling moves are not returned
-std::vector<std::string> Generate_Piece_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks);
+// move that piece can make and add them to "moves". When "ignore_non_attacks" == true, straight-line
+// pawn moves, en passant, and castling moves are not added
+void Generate_Piece_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves);
 
 // Given some gamestate, some square index, and the current player's color, determine
 // if that square is under attack by any opposing piece
 bool Square_Under_Attack(const Gamestate& g, const int index, const char player_color);
 
-// Given some gamestate and a move to make, update the gamestate accordingly
-Gamestate Simulate_Move(const Gamestate& g, const std::string move);
+// Get every piece of either color that attacks the given square, treating only the squares in
+// "occupied" as blockers (so pieces can be removed to see what attacks through them)
+Bitboard Attackers_To(const Gamestate& g, const int index, const Bitboard occupied);
+
+// Get the castling_rights bits that stay available after a move to or from the given square
+int Castling_Mask(const int index);
+
+// Make the given move on the gamestate in place, saving what is needed to take it back in "undo"
+void Make_Move(Gamestate& g, const Move move, Undo_Record& undo);
+
+// Take back a move made by Make_Move(), restoring the gamestate from "undo"
+void Unmake_Move(Gamestate& g, const Move move, const Undo_Record& undo);
+
+// Pass the turn to the other player without moving anything (not a legal chess move; used by
+// null-move pruning). Must not be used when the player to move is in check
+void Make_Null_Move(Gamestate& g, Undo_Record& undo);
+
+// Take back a move made by Make_Null_Move()
+void Unmake_Null_Move(Gamestate& g, const Undo_Record& undo);
+
+// Given some gamestate and a move to make, return a copy of the gamestate with the move made
+Gamestate Simulate_Move(const Gamestate& g, const Move move);
+
+// Convert a move in UCI format (ex. "e2e4" or "e7e8q") into the matching valid move for the
+// given gamestate. Returns NULL_MOVE if no valid move matches
+Move Parse_Move(const Gamestate& g, const std::string uci);
 
 // Given a list of possible moves, select one at random and return it
-std::string Get_Random_Move(const std::vector<std::string> all_moves);
+Move Get_Random_Move(const Move_List& all_moves);
+
+// Fill in "status" for the player to move: their legal moves, whether they are in check, and
+// whether the game is over. Use this instead of calling Game_Draw(), Game_Checkmate(), and
+// Generate_Player_Moves() separately, since each of those generates every move again
+void Get_Node_Status(const Gamestate& g, Node_Status& status);
+
+// Check the draw rules that do not depend on the legal moves: the fifty-move rule, or the same
+// position coming up for the third time
+bool Draw_Conditions(const Gamestate& g);
 
 // Check if the given gamestate is at a draw
 bool Game_Draw(const Gamestate& g);
@@ -112,1062 +207,688 @@ int Convert_to_Index(const std::string square)
 	return ((square[1] - 49) * 8) + (square[0] - 97);
 }
 
-std::vector<std::string> Generate_Pawn_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks)
+void Add_Target_Moves(Move_List& moves, const Gamestate& g, const int index, Bitboard targets)
 {
-	std::vector<std::string> pawn_moves;
-
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
-
-	// If the pawn is white
-	if (g.board[index] == 'P')
+	// Add one move for every set bit in the targets, flagging the ones that land on a piece as captures
+	while (targets)
 	{
-		// If straight moves and en passant are not ignored
-		if (!ignore_non_attacks)
-		{
-			// If rank < 7 and there is no piece N of the pawn
-			if (index < 48 && g.board[index + N] == ' ')
-			{
-				// Add the N move
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N));
-
-				// If the pawn is on the 2nd rank, and there is no piece N * 2 of the pawn
-				if (curr_square[1] == '2' && g.board[index + N*2] == ' ')
-				{
-					// Add the N*2 move
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N*2));
-				}
-			}
-
-			// If rank == 7 and there is no piece N of the pawn
-			if (curr_square[1] == '7' && g.board[index + N] == ' ')
-			{
-				// Add all possible promotion moves
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + N) + 'b');
-			}
+		int next_index = Pop_LSB(targets);
+		moves.push_back(Create_Move(index, next_index, (g.board[next_index] != ' ' ? CAPTURE : QUIET)));
+	}
+}
 
-			// If there is an en passant target NW of the pawn (and NW is in bounds)
-			if (index % 8 != 0 && g.en_passant_target == Convert_to_Algebraic(index + NW))
-			{
-				// If the pawn started on rank 7
-				if (curr_square[1] == '7')
-				{
-					// Add the NW capture plus any promotion
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'q');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'n');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'r');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'b');
-				}
-				// Else just add the NW capture
-				else
-				{
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW));
-				}
-			}
-			// Repeat for NE
-			if (index % 8 != 7 && g.en_passant_target == Convert_to_Algebraic(index + NE))
-			{
-				// If the pawn started on rank 7
-				if (curr_square[1] == '7')
-				{
-					// Add the NE capture plus any promotion
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'q');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'n');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'r');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'b');
-				}
-				// Else just add the NE capture
-				else
-				{
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE));
-				}
-			}
-		}
+void Add_Pawn_Target_Moves(Move_List& moves, const Gamestate& g, const int index, Bitboard targets)
+{
+	while (targets)
+	{
+		int next_index = Pop_LSB(targets);
+		int capture = (g.board[next_index] != ' ' ? CAPTURE : QUIET);
 
-		// If there is an enemy piece NW of the pawn (and NW is in bounds)
-		if (index % 8 != 0 && islower(g.board[index + NW]))
+		// Either the first or last rank, since pawns never stand on their own back rank
+		if (Square_BB(next_index) & (RANK_1 | RANK_8))
 		{
-			// If the pawn started on rank 7
-			if (curr_square[1] == '7')
-			{
-				// Add the NW capture plus any promotion
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW) + 'b');
-			}
-			// Else just add the NW capture
-			else
-			{
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NW));
-			}
+			moves.push_back(Create_Move(index, next_index, PROMOTION | capture | (QUEEN - KNIGHT)));
+			moves.push_back(Create_Move(index, next_index, PROMOTION | capture | (KNIGHT - KNIGHT)));
+			moves.push_back(Create_Move(index, next_index, PROMOTION | capture | (ROOK - KNIGHT)));
+			moves.push_back(Create_Move(index, next_index, PROMOTION | capture | (BISHOP - KNIGHT)));
 		}
-		// Repeat for NE
-		if (index % 8 != 7 && islower(g.board[index + NE]))
+		else
 		{
-			// If the pawn started on rank 7
-			if (curr_square[1] == '7')
-			{
-				// Add the NE capture plus any promotion
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE) + 'b');
-			}
-			// Else just add the NE capture
-			else
-			{
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + NE));
-			}
+			moves.push_back(Create_Move(index, next_index, capture));
 		}
 	}
+}
 
-	// Else if the pawn is black
-	else if (g.board[index] == 'p')
+void Add_Castling_Moves(Move_List& moves, const Gamestate& g, const int index)
+{
+	// If the king is white
+	if (isupper(g.board[index]))
 	{
-		// If straight moves and en passant are not ignored
-		if (!ignore_non_attacks)
+		// If kingside castling is still available and the kingside is clear
+		// (indexes 5, 6 = f1, g1)
+		if ((g.castling_rights & WHITE_KINGSIDE) && !(g.all_pieces & (Square_BB(5) | Square_BB(6))))
 		{
-			// If rank > 2 and there is no piece S of the pawn
-			if (index > 15 && g.board[index + S] == ' ')
+			// If neither of those squares nor the king are under attack
+			if (!Square_Under_Attack(g, index, 'w') && !Square_Under_Attack(g, 5, 'w') && !Square_Under_Attack(g, 6, 'w'))
 			{
-				// Add the S move
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S));
-
-				// If the pawn is on the 7th rank, and there is no piece S * 2 of the pawn
-				if (curr_square[1] == '7' && g.board[index + S*2] == ' ')
-				{
-					// Add the S*2 move
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S*2));
-				}
+				// Then kingside castling (e1g1) is valid
+				moves.push_back(Create_Move(index, 6, KING_CASTLE));
 			}
+		}
 
-			// If rank == 2 and there is no piece S of the pawn
-			if (curr_square[1] == '2' && g.board[index + S] == ' ')
-			{
-				// Add all possible promotion moves
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + S) + 'b');
-			}
-	
-			// If there is an en passant target SW of the pawn and SW is in bounds
-			if (index % 8 != 0 && g.en_passant_target == Convert_to_Algebraic(index + SW))
-			{
-				// If the pawn started on rank 2
-				if (curr_square[1] == '2')
-				{
-					// Add the SW capture plus any promotion
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'q');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'n');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'r');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'b');
-				}
-				// Else just add the SW capture
-				else
-				{
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW));
-				}
-			}
-			// Repeat for SE
-			if (index % 8 != 7 && g.en_passant_target == Convert_to_Algebraic(index + SE))
+		// If queenside castling is still available and the queenside is clear
+		// (indexes 1, 2, 3 = b1, c1, d1)
+		if ((g.castling_rights & WHITE_QUEENSIDE) && !(g.all_pieces & (Square_BB(1) | Square_BB(2) | Square_BB(3))))
+		{
+			// If neither the squares the king crosses nor the king are under attack
+			// (the rook may pass through an attacked b1)
+			if (!Square_Under_Attack(g, index, 'w') && !Square_Under_Attack(g, 2, 'w') && !Square_Under_Attack(g, 3, 'w'))
 			{
-				// If the pawn started on rank 2
-				if (curr_square[1] == '2')
-				{
-					// Add the SE capture plus any promotion
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'q');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'n');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'r');
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'b');
-				}
-				// Else just add the SE capture
-				else
-				{
-					pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE));
-				}
+				// Then queenside castling (e1c1) is valid
+				moves.push_back(Create_Move(index, 2, QUEEN_CASTLE));
 			}
 		}
+	}
 
-
-		// If there is an enemy piece SW of the pawn (and SW is in bounds)
-		if (index % 8 != 0 && isupper(g.board[index + SW]))
+	// If the king is black
+	if (islower(g.board[index]))
+	{
+		// If kingside castling is still available and the kingside is clear
+		// (indexes 61, 62 = f8, g8)
+		if ((g.castling_rights & BLACK_KINGSIDE) && !(g.all_pieces & (Square_BB(61) | Square_BB(62))))
 		{
-			// If the pawn started on rank 2
-			if (curr_square[1] == '2')
-			{
-				// Add the SW capture plus any promotion
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW) + 'b');
-			}
-			// Else just add the SW capture
-			else
+			// If neither of those squares nor the king are under attack
+			if (!Square_Under_Attack(g, index, 'b') && !Square_Under_Attack(g, 61, 'b') && !Square_Under_Attack(g, 62, 'b'))
 			{
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SW));
+				// Then kingside castling (e8g8) is valid
+				moves.push_back(Create_Move(index, 62, KING_CASTLE));
 			}
 		}
-		// Repeat for SE
-		if (index % 8 != 7 && isupper(g.board[index + SE]))
+
+		// If queenside castling is still available and the queenside is clear
+		// (indexes 57, 58, 59 = b8, c8, d8)
+		if ((g.castling_rights & BLACK_QUEENSIDE) && !(g.all_pieces & (Square_BB(57) | Square_BB(58) | Square_BB(59))))
 		{
-			// If the pawn started on rank 2
-			if (curr_square[1] == '2')
+			// If neither the squares the king crosses nor the king are under attack
+			if (!Square_Under_Attack(g, index, 'b') && !Square_Under_Attack(g, 58, 'b') && !Square_Under_Attack(g, 59, 'b'))
 			{
-				// Add the SE capture plus any promotion
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'q');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'n');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'r');
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE) + 'b');
-			}
-			// Else just add the SE capture
-			else
-			{
-				pawn_moves.push_back(curr_square + Convert_to_Algebraic(index + SE));
+				// Then queenside castling (e8c8) is valid
+				moves.push_back(Create_Move(index, 58, QUEEN_CASTLE));
 			}
 		}
 	}
+}
 
-	return pawn_moves;
+Bitboard Piece_Attacks(const Gamestate& g, const int index)
+{
+	// Determine what kind of piece it is, and look up the squares it attacks
+	switch (Piece_Type(g.board[index]))
+	{
+		case PAWN:
+			return PAWN_ATTACKS[Piece_Color(g.board[index])][index];
+		case KNIGHT:
+			return KNIGHT_ATTACKS[index];
+		case BISHOP:
+			return Bishop_Attacks(index, g.all_pieces);
+		case ROOK:
+			return Rook_Attacks(index, g.all_pieces);
+		case QUEEN:
+			return Queen_Attacks(index, g.all_pieces);
+		case KING:
+			return KING_ATTACKS[index];
+		default:
+			return 0;
+	}
 }
 
-std::vector<std::string> Generate_Bishop_Moves(const Gamestate& g, const int index)
+void Generate_Pawn_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves)
 {
-	std::vector<std::string> bishop_moves;
+	int color = Piece_Color(g.board[index]);
+	Bitboard pawn = Square_BB(index);
 
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
+	// Diagonal captures are only possible onto enemy pieces
+	Bitboard targets = PAWN_ATTACKS[color][index] & g.occupancy[1 - color];
 
-	// Check each diagonal direction one at a time
-	std::vector<int> diagonals = {NW, NE, SE, SW};
-	for (int i = 0; i < 4; i++)
+	// If straight moves and en passant are not ignored
+	if (!ignore_non_attacks)
 	{
-		int dir = diagonals[i];
+		Bitboard empty = ~g.all_pieces;
 
-		// Keep checking that direction until a piece or the edge of the board is encountered
-		int next_index = index;
-		while (true)
+		// Move one square forward if it is open
+		Bitboard single_push = (color == WHITE ? pawn << N : pawn >> N) & empty;
+		targets |= single_push;
+
+		// If the pawn is still on its starting rank and the first square was open, it can also move two squares
+		if (single_push && (pawn & (color == WHITE ? RANK_2 : RANK_7)))
 		{
-			// Check if the next index will be out bounds
-			// Check top rank and leftmost file
-			if (dir == NW && (next_index % 8 == 0 || next_index >= 56))
-			{
-				break;
-			}
-			// Check top rank and rightmost file
-			else if (dir == NE && (next_index % 8 == 7 || next_index >= 56))
+			Bitboard double_push = (color == WHITE ? single_push << N : single_push >> N) & empty;
+			if (double_push)
 			{
-				break;
+				moves.push_back(Create_Move(index, LSB(double_push), DOUBLE_PAWN_PUSH));
 			}
-			// Check bottom rank and rightmost file
-			else if (dir == SE && (next_index % 8 == 7 || next_index <= 7))
-			{
-				break;
-			}
-			// Check bottom rank and leftmost file
-			else if (dir == SW && (next_index % 8 == 0 || next_index <= 7))
-			{
-				break;
-			}
-
-			// Update the next index
-			next_index += dir;
+		}
 
-			// Check if there's a piece
-			if (g.board[next_index] != ' ')
-			{
-				// If the piece is the same color as the bishop
-				if (isupper(g.board[index]) && isupper(g.board[next_index]) || islower(g.board[index]) && islower(g.board[next_index]))
-				{
-					// Then the bishop can't move any farther in this direction
-					break;
-				}
-				// Else the pieces are opposite colors
-				else
-				{
-					// Add the capturing move, then the bishop cannot move any farther
-					bishop_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-					break;
-				}
-			}
-			// Else the square is open
-			else
-			{
-				// Add the move
-				bishop_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-			}
+		// If the pawn attacks the en passant target, it can capture onto it
+		if (g.en_passant_square != -1 && (PAWN_ATTACKS[color][index] & Square_BB(g.en_passant_square)))
+		{
+			moves.push_back(Create_Move(index, g.en_passant_square, EP_CAPTURE));
 		}
 	}
 
-	return bishop_moves;
+	// Add every target square, expanding moves onto the last rank into all possible promotions
+	Add_Pawn_Target_Moves(moves, g, index, targets);
 }
 
-std::vector<std::string> Generate_Rook_Moves(const Gamestate& g, const int index)
+void Generate_Bishop_Moves(const Gamestate& g, const int index, Move_List& moves)
 {
-	std::vector<std::string> rook_moves;
-
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
-
-	// Check each straight direction one at a time
-	std::vector<int> straights = {N, E, S, W};
-	for (int i = 0; i < 4; i++)
-	{
-		int dir = straights[i];
-
-		// Keep checking that direction until a piece or the edge of the board is encountered
-		int next_index = index;
-		while (true)
-		{
-			// Check if this loop will be out bounds
-			// Check top rank
-			if (dir == N && (next_index >= 56))
-			{
-				break;
-			}
-			// Check rightmost file
-			else if (dir == E && (next_index % 8 == 7))
-			{
-				break;
-			}
-			// Check bottom rank
-			else if (dir == S && (next_index <= 7))
-			{
-				break;
-			}
-			// Check leftmost file
-			else if (dir == W && (next_index % 8 == 0))
-			{
-				break;
-			}
+	// The bishop can move along each diagonal up to the first piece, and capture it if it is an enemy
+	Bitboard targets = Bishop_Attacks(index, g.all_pieces) & ~g.occupancy[Piece_Color(g.board[index])];
+	Add_Target_Moves(moves, g, index, targets);
+}
 
-			// Update the next index
-			next_index += dir;
+void Generate_Rook_Moves(const Gamestate& g, const int index, Move_List& moves)
+{
+	// The rook can move along each straight line up to the first piece, and capture it if it is an enemy
+	Bitboard targets = Rook_Attacks(index, g.all_pieces) & ~g.occupancy[Piece_Color(g.board[index])];
+	Add_Target_Moves(moves, g, index, targets);
+}
 
-			// Check if there's a piece
-			if (g.board[next_index] != ' ')
-			{
-				// If the piece is the same color as the rook
-				if (isupper(g.board[index]) && isupper(g.board[next_index]) || islower(g.board[index]) && islower(g.board[next_index]))
-				{
-					// Then the rook can't move any farther in this direction
-					break;
-				}
-				// Else the pieces are opposite colors
-				else
-				{
-					// Add the capturing move, then the rook cannot move any farther
-					rook_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-					break;
-				}
-			}
-			// Else the square is open
-			else
-			{
-				// Add the move
-				rook_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-			}
-		}
-	}
+void Generate_Knight_Moves(const Gamestate& g, const int index, Move_List& moves)
+{
+	// The knight can jump to any in-bounds square that is not occupied by a friendly piece
+	Bitboard targets = KNIGHT_ATTACKS[index] & ~g.occupancy[Piece_Color(g.board[index])];
+	Add_Target_Moves(moves, g, index, targets);
+}
 
-	return rook_moves;
+void Generate_Queen_Moves(const Gamestate& g, const int index, Move_List& moves)
+{
+	// The queen moves like a rook and a bishop combined
+	Bitboard targets = Queen_Attacks(index, g.all_pieces) & ~g.occupancy[Piece_Color(g.board[index])];
+	Add_Target_Moves(moves, g, index, targets);
 }
 
-std::vector<std::string> Generate_Knight_Moves(const Gamestate& g, const int index)
+void Generate_King_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves)
 {
-	std::vector<std::string> knight_moves;
-
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
-
-	// Possible knight moves and their relative indices:
-	// ---------------------
-	// |   |+15|   |+17|   |
-	// ---------------------
-	// |+6 |   |   |   |+10|
-	// ---------------------
-	// |   |   |+0 |   |   |
-	// ---------------------
-	// |-10|   |   |   |-6 |
-	// ---------------------
-	// |   |-17|   |-15|   |
-	// ---------------------
-
-	// Determine which moves are in bounds
-	std::vector<int> possible_moves;
-
-	// Check +6
-	if (index % 8 > 1 && index < 56)
-	{
-		possible_moves.push_back(6);
-	}
-	// Check +15
-	if (index % 8 > 0 && index < 48)
-	{
-		possible_moves.push_back(15);
-	}
-	// Check +17
-	if (index % 8 < 7 && index < 48)
-	{
-		possible_moves.push_back(17);
-	}
-	// Check +10
-	if (index % 8 < 6 && index < 56)
-	{
-		possible_moves.push_back(10);
-	}
-	// Check -6
-	if (index % 8 < 6 && index >= 8)
-	{
-		possible_moves.push_back(-6);
-	}
-	// Check -15
-	if (index % 8 < 7 && index >= 16)
-	{
-		possible_moves.push_back(-15);
-	}
-	// Check -17
-	if (index % 8 > 0 && index >= 16)
-	{
-		possible_moves.push_back(-17);
-	}
-	// Check -10
-	if (index % 8 > 1 && index >= 8)
-	{
-		possible_moves.push_back(-10);
-	}
+	// The king can step to any adjacent square that is not occupied by a friendly piece
+	Bitboard targets = KING_ATTACKS[index] & ~g.occupancy[Piece_Color(g.board[index])];
+	Add_Target_Moves(moves, g, index, targets);
 
-	// For every in-bounds move, determine if it is a valid move
-	for (int i = 0; i < possible_moves.size(); i++)
+	// If castling moves are not ignored
+	if (!ignore_non_attacks)
 	{
-		int next_index = index + possible_moves[i];
-
-		// Check if there's a piece at the new square
-		if (g.board[next_index] != ' ')
-		{
-			// If the piece is the opposite color as the knight
-			if (isupper(g.board[index]) && islower(g.board[next_index]) || islower(g.board[index]) && isupper(g.board[next_index]))
-			{
-				// Add the capturing move
-				knight_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-			}
-		}
-		// Else the square is open
-		else
-		{
-			// Add the move
-			knight_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-		}
+		Add_Castling_Moves(moves, g, index);
 	}
-
-	return knight_moves;
 }
 
-std::vector<std::string> Generate_Queen_Moves(const Gamestate& g, const int index)
+Bitboard Pinned_Pieces(const Gamestate& g, const int color)
 {
-	std::vector<std::string> queen_moves;
+	int enemy = 1 - color;
+	int king_index = g.King_Square(color);
+	Bitboard pinned = 0;
 
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
+	// Find every enemy slider that would attack the king if nothing were in the way
+	Bitboard snipers = (Rook_Attacks(king_index, 0) & (g.pieces[enemy][ROOK] | g.pieces[enemy][QUEEN]))
+					 | (Bishop_Attacks(king_index, 0) & (g.pieces[enemy][BISHOP] | g.pieces[enemy][QUEEN]));
 
-	// Check each direction one at a time
-	std::vector<int> directions = {NW, N, NE, E, SE, S, SW, W};
-	for (int i = 0; i < 8; i++)
+	while (snipers)
 	{
-		int dir = directions[i];
-
-		// Keep checking that direction until a piece or the edge of the board is encountered
-		int next_index = index;
-		while (true)
+		// If exactly one piece stands between them and it is ours, that piece is pinned
+		Bitboard blockers = BETWEEN[king_index][Pop_LSB(snipers)] & g.all_pieces;
+		if (Pop_Count(blockers) == 1)
 		{
-			// Check if the next index will be out bounds
-			// Check top rank and leftmost file
-			if (dir == NW && (next_index % 8 == 0 || next_index >= 56))
-			{
-				break;
-			}
-			// Check top rank
-			if (dir == N && next_index >= 56)
-			{
-				break;
-			}
-			// Check top rank and rightmost file
-			else if (dir == NE && (next_index % 8 == 7 || next_index >= 56))
-			{
-				break;
-			}
-			// Check rightmost file
-			else if (dir == E && next_index % 8 == 7)
-			{
-				break;
-			}
-			// Check bottom rank and rightmost file
-			else if (dir == SE && (next_index % 8 == 7 || next_index <= 7))
-			{
-				break;
-			}
-			// Check bottom rank
-			else if (dir == S && next_index <= 7)
-			{
-				break;
-			}
-			// Check leftmost file
-			else if (dir == W && next_index % 8 == 0)
-			{
-				break;
-			}
-			// Check bottom rank and leftmost file
-			else if (dir == SW && (next_index % 8 == 0 || next_index <= 7))
-			{
-				break;
-			}
-
-			// Update the next index
-			next_index += dir;
-
-			// Check if there's a piece
-			if (g.board[next_index] != ' ')
-			{
-				// If the piece is the same color as the queen
-				if (isupper(g.board[index]) && isupper(g.board[next_index]) || islower(g.board[index]) && islower(g.board[next_index]))
-				{
-					// Then the queen can't move any farther in this direction
-					break;
-				}
-				// Else the pieces are opposite colors
-				else
-				{
-					// Add the capturing move, then the queen cannot move any farther
-					queen_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-					break;
-				}
-			}
-			// Else the square is open
-			else
-			{
-				// Add the move
-				queen_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
-			}
+			pinned |= blockers & g.occupancy[color];
 		}
 	}
 
-	return queen_moves;
+	return pinned;
 }
 
-std::vector<std::string> Generate_King_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks)
+Move_List Generate_Player_Moves(const Gamestate& g, const char player_color)
 {
-	std::vector<std::string> king_moves;
+	// Store the valid moves
+	Move_List valid_moves;
+	Generate_Legal_Moves(g, (player_color == 'w' ? WHITE : BLACK), valid_moves);
 
-	// Get the algebraic format of the square
-	std::string curr_square = Convert_to_Algebraic(index);
+	// Return the complete list
+	return valid_moves;
+}
 
-	// Determine which moves are in bounds
-	std::vector<int> possible_moves;
+Bitboard Generate_Legal_Moves(const Gamestate& g, const int color, Move_List& valid_moves, const int gen_type, const Bitboard sources)
+{
+	int enemy = 1 - color;
+	int king_index = g.King_Square(color);
+	Bitboard own = g.occupancy[color];
 
-	// Check NW
-	if (index % 8 != 0 && index < 56)
-	{
-		possible_moves.push_back(NW);
-	}
-	// Check N
-	if (index < 56)
-	{
-		possible_moves.push_back(N);
-	}
-	// Check NE
-	if (index % 8 != 7 && index < 56)
-	{
-		possible_moves.push_back(NE);
-	}
-	// Check E
-	if (index % 8 != 7)
-	{
-		possible_moves.push_back(E);
-	}
-	// Check SE
-	if (index % 8 != 7 && index >= 8)
-	{
-		possible_moves.push_back(SE);
-	}
-	// Check S
-	if (index >= 8)
-	{
-		possible_moves.push_back(S);
-	}
-	// Check SW
-	if (index % 8 != 0 && index >= 8)
-	{
-		possible_moves.push_back(SW);
-	}
-	// Check W
-	if (index % 8 != 0)
-	{
-		possible_moves.push_back(W);
-	}
+	// Find the enemy pieces giving check
+	Bitboard checkers = Attackers_To(g, king_index, g.all_pieces) & g.occupancy[enemy];
 
-	// For every in-bounds move, determine if it is a valid move
-	for (int i = 0; i < possible_moves.size(); i++)
-	{
-		int next_index = index + possible_moves[i];
+	// Work out which kinds of moves were asked for. Promotions count along with the captures, and
+	// every way out of check is needed when only captures were asked for
+	bool captures = (gen_type != GEN_QUIETS);
+	bool quiet_moves = (gen_type != GEN_CAPTURES || checkers);
 
-		// Check if there's a piece at the new square
-		if (g.board[next_index] != ' ')
+	// Squares the generated moves may land on: enemy pieces for captures, empty squares otherwise
+	Bitboard gen_mask = (captures ? g.occupancy[enemy] : 0) | (quiet_moves ? ~g.all_pieces : 0);
+
+	// The king can step to any adjacent square that is not attacked. The king itself is taken off
+	// the board first, so squares further along a checking slider's line count as attacked
+	if (sources & Square_BB(king_index))
+	{
+		Bitboard king_targets = KING_ATTACKS[king_index] & gen_mask;
+		Bitboard without_king = g.all_pieces ^ Square_BB(king_index);
+		while (king_targets)
 		{
-			// If the piece is the opposite color as the king
-			if (isupper(g.board[index]) && islower(g.board[next_index]) || islower(g.board[index]) && isupper(g.board[next_index]))
+			int next_index = Pop_LSB(king_targets);
+			if (!(Attackers_To(g, next_index, without_king) & g.occupancy[enemy]))
 			{
-				// Add the capturing move
-				king_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
+				valid_moves.push_back(Create_Move(king_index, next_index, (g.board[next_index] != ' ' ? CAPTURE : QUIET)));
 			}
 		}
-		// Else the square is open
-		else
+
+		// Castling is only possible when not in check
+		if (!checkers && quiet_moves)
 		{
-			// Add the move
-			king_moves.push_back(curr_square + Convert_to_Algebraic(next_index));
+			Add_Castling_Moves(valid_moves, g, king_index);
 		}
 	}
 
-	// If castling moves are not ignored
-	if (!ignore_non_attacks)
+	// In double check only the king can move
+	if (Pop_Count(checkers) > 1)
 	{
-		// Check the castles string
-		for (int i = 0; i < g.castles.length(); i++)
-		{
-			// If the king is white
-			if (isupper(g.board[index]))
-			{
-				// If 'K' is still part of the castles string and the kingside is clear
-				// (indexes 5, 6 = f1, g1)
-				if (g.castles[i] == 'K' && g.board[5] == ' ' && g.board[6] == ' ')
-				{
-					// If neither of those squares nor the king are under attack
-					if (!Square_Under_Attack(g, i, 'w') && !Square_Under_Attack(g, 5, 'w') && !Square_Under_Attack(g, 6, 'w'))
-					{
-						// Then kingside castling (e1g1) is valid
-						king_moves.push_back(curr_square + "g1");
-					}
-				}
-
-				// If 'Q' is still part of the castles string and the queenside is clear
-				// (indexes 1, 2, 3 = b1, c1, d1)
-				if (g.castles[i] == 'Q' && g.board[1] == ' ' && g.board[2] == ' ' && g.board[3] == ' ')
-				{
-					// If none of those squares nor the king are under attack
-					if (!Square_Under_Attack(g, i, 'w') && !Square_Under_Attack(g, 1, 'w') && !Square_Under_Attack(g, 2, 'w') && !Square_Under_Attack(g, 3, 'w'))
-					{
-						// Then queenside castling (e1b1) is valid
-						king_moves.push_back(curr_square + "b1");
-					}
-				}
-			}
-
-			// If the king is black
-			if (islower(g.board[index]))
-			{
-				// If 'k' is still part of the castles string and the kingside is clear
-				// (indexes 61, 62 = f8, g8)
-				if (g.castles[i] == 'k' && g.board[61] == ' ' && g.board[62] == ' ')
-				{
-					// If neither of those squares nor the king are under attack
-					if (!Square_Under_Attack(g, i, 'b') && !Square_Under_Attack(g, 61, 'b') && !Square_Under_Attack(g, 62, 'b'))
-					{
-						// Then kingside castling (e8g8) is valid
-						king_moves.push_back(curr_square + "g8");
-					}
-				}
-
-				// If 'q' is still part of the castles string and the queenside is clear
-				// (indexes 57, 58, 59 = b8, c8, d8)
-				if (g.castles[i] == 'q' && g.board[57] == ' ' && g.board[58] == ' ' && g.board[59] == ' ')
-				{
-					// If none of those squares nor the king are under attack
-					if (!Square_Under_Attack(g, i, 'b') && !Square_Under_Attack(g, 57, 'b') && !Square_Under_Attack(g, 58, 'b') && !Square_Under_Attack(g, 59, 'b'))
-					{
-						// Then queenside castling (e8b8) is valid
-						king_moves.push_back(curr_square + "b8");
-					}
-				}
-			}
-		}
+		return checkers;
 	}
 
-	return king_moves;
-}
-
-std::vector<std::string> Generate_Player_Moves(const Gamestate& g, const char player_color)
-{
-	// Store all valid moves in this vector
-	std::vector<std::string> valid_moves;
+	// Out of check, any square not holding one of our pieces is a possible target. In single check,
+	// the other pieces have to capture the checker or block the line between it and the king
+	Bitboard evasion_mask = ~Bitboard(0);
+	if (checkers)
+	{
+		evasion_mask = checkers | BETWEEN[king_index][LSB(checkers)];
+	}
+	Bitboard target_mask = evasion_mask & gen_mask;
 
-	// Temp vector to store valid moves for each piece
-	std::vector<std::string> new_moves;
+	Bitboard pinned = Pinned_Pieces(g, color);
+	Bitboard empty = ~g.all_pieces;
 
-	// Iterate over every square on the board
-	for (int i = 0; i < g.board.size(); i++)
+	// Iterate over every other piece of the player's color that was asked for
+	Bitboard own_pieces = own & ~Square_BB(king_index) & sources;
+	while (own_pieces)
 	{
-		// If the piece and player are the same color
-		if ((isupper(g.board[i]) && player_color == 'w') || (islower(g.board[i]) && player_color == 'b'))
-		{
-			// Generate all the valid moves that piece can make
-			// We want to include non-attacking moves, so the last parameter must be false
-			new_moves = Generate_Piece_Moves(g, i, false);
+		int index = Pop_LSB(own_pieces);
 
-			// Append the new moves to the total list
-			valid_moves.insert(valid_moves.end(), new_moves.begin(), new_moves.end());
+		// A pinned piece can only move along the line through it and the king
+		Bitboard pin_line = ~Bitboard(0);
+		if (pinned & Square_BB(index))
+		{
+			pin_line = LINE[king_index][index];
 		}
-	}
-
-	// Now that we have all the available valid moves, we need to check if any of these moves
-	// will allow our king to be under attack
-
-	// Simulate every move we have generated thus far to see if any of them will put the king in danger
-	Gamestate sim_state(g);
-	int king_index;
+		Bitboard allowed = target_mask & pin_line;
 
-	// Make a copy of the valid moves so we can iterate and delete simultaneously
-	std::vector<std::string> iter_moves = valid_moves;
+		if (Piece_Type(g.board[index]) != PAWN)
+		{
+			Add_Target_Moves(valid_moves, g, index, Piece_Attacks(g, index) & allowed);
+			continue;
+		}
 
-	for (int i = 0; i < iter_moves.size(); i++)
-	{
-		// Simulate the move from the current state
-		sim_state = Simulate_Move(g, iter_moves[i]);
+		// Pawns capture diagonally onto enemy pieces and push forward onto empty squares. Pushes
+		// onto the last rank are promotions, which count along with the captures
+		Bitboard pawn = Square_BB(index);
+		Bitboard single_push = (color == WHITE ? pawn << N : pawn >> N) & empty;
+		Bitboard push_allowed = evasion_mask & pin_line & ((captures ? RANK_1 | RANK_8 : 0) | (quiet_moves ? ~(RANK_1 | RANK_8) : 0));
+		Add_Pawn_Target_Moves(valid_moves, g, index, (PAWN_ATTACKS[color][index] & g.occupancy[enemy] & allowed) | (single_push & push_allowed));
 
-		// Find this player's king's square index
-		for (int j = 0; j < sim_state.board.size(); j++)
+		// If the pawn is still on its starting rank and the first square was open, it can also move two squares
+		if (quiet_moves && single_push && (pawn & (color == WHITE ? RANK_2 : RANK_7)))
 		{
-			if ((sim_state.board[j] == 'K' && player_color == 'w') || (sim_state.board[j] == 'k' && player_color == 'b'))
+			Bitboard double_push = (color == WHITE ? single_push << N : single_push >> N) & empty & evasion_mask & pin_line;
+			if (double_push)
 			{
-				king_index = j;
+				valid_moves.push_back(Create_Move(index, LSB(double_push), DOUBLE_PAWN_PUSH));
 			}
 		}
 
-		// Check if the king's square is under attack in the new state
-		if (Square_Under_Attack(sim_state, king_index, player_color))
+		// En passant removes two pieces from the same rank, which can expose the king in ways the
+		// pin check does not see, so check the position after the capture directly
+		if (captures && g.en_passant_square != -1 && (PAWN_ATTACKS[color][index] & Square_BB(g.en_passant_square)))
 		{
-			// The king is under attack, so this move is not valid - remove it
-			valid_moves.erase(std::remove(valid_moves.begin(), valid_moves.end(), iter_moves[i]), valid_moves.end());
+			int captured_index = g.en_passant_square + (color == WHITE ? S : N);
+			Bitboard occupied = (g.all_pieces ^ pawn ^ Square_BB(captured_index)) | Square_BB(g.en_passant_square);
+
+			Bitboard sliders = (Bishop_Attacks(king_index, occupied) & (g.pieces[enemy][BISHOP] | g.pieces[enemy][QUEEN]))
+							 | (Rook_Attacks(king_index, occupied) & (g.pieces[enemy][ROOK] | g.pieces[enemy][QUEEN]));
+
+			// Any other check must be answered by taking the checking pawn (or blocking with the move)
+			bool answers_check = !checkers || (checkers & Square_BB(captured_index)) || (evasion_mask & Square_BB(g.en_passant_square));
+
+			if (answers_check && !sliders)
+			{
+				valid_moves.push_back(Create_Move(index, g.en_passant_square, EP_CAPTURE));
+			}
 		}
 	}
 
-	// Return the complete list
-	return valid_moves;
+	return checkers;
 }
 
-std::vector<std::string> Generate_Piece_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks)
+bool Is_Legal_Move(const Gamestate& g, const Move move)
 {
-	// Store the valid moves
-	std::vector<std::string> moves;
-
-	// Determine what kind of piece it is, and generate its moves
-	// If piece is a pawn
-	if (g.board[index] == 'P' || g.board[index] == 'p')
+	int color = (g.next_turn == 'w' ? WHITE : BLACK);
+	if (move == NULL_MOVE || !(g.occupancy[color] & Square_BB(Move_From(move))))
 	{
-		// Get the new moves, then copy them to the existing list
-		moves = Generate_Pawn_Moves(g, index, ignore_non_attacks);
+		return false;
 	}
 
-	// If piece is a bishop
-	else if (g.board[index] == 'B' || g.board[index] == 'b')
+	// Only generate the moves of the piece standing on the from-square
+	Move_List piece_moves;
+	Generate_Legal_Moves(g, color, piece_moves, GEN_ALL, Square_BB(Move_From(move)));
+	return piece_moves.Contains(move);
+}
+
+void Generate_Piece_Moves(const Gamestate& g, const int index, const bool ignore_non_attacks, Move_List& moves)
+{
+	// Determine what kind of piece it is, and generate its moves
+	switch (Piece_Type(g.board[index]))
 	{
-		moves = Generate_Bishop_Moves(g, index);
+		case PAWN:
+			Generate_Pawn_Moves(g, index, ignore_non_attacks, moves);
+			break;
+		case BISHOP:
+			Generate_Bishop_Moves(g, index, moves);
+			break;
+		case ROOK:
+			Generate_Rook_Moves(g, index, moves);
+			break;
+		case KNIGHT:
+			Generate_Knight_Moves(g, index, moves);
+			break;
+		case QUEEN:
+			Generate_Queen_Moves(g, index, moves);
+			break;
+		case KING:
+			Generate_King_Moves(g, index, ignore_non_attacks, moves);
+			break;
+		default:
+			std::cout << "There is no piece on square " << Convert_to_Algebraic(index) << ".\n";
 	}
+}
+
+bool Square_Under_Attack(const Gamestate& g, const int index, const char player_color)
+{
+	// Attacks are symmetric, so instead of generating the attacks of every enemy piece, look
+	// outward from the square as each kind of piece and see if an enemy piece of that kind is there
+	int color = (player_color == 'w' ? WHITE : BLACK);
+	int enemy = 1 - color;
 
-	// If piece is a rook
-	else if (g.board[index] == 'R' || g.board[index] == 'r')
+	// A pawn of our color on this square would attack exactly the squares enemy pawns attack it from
+	if (PAWN_ATTACKS[color][index] & g.pieces[enemy][PAWN])
 	{
-		moves = Generate_Rook_Moves(g, index);
+		return true;
 	}
 
-	// If piece is a knight
-	else if (g.board[index] == 'N' || g.board[index] == 'n')
+	if (KNIGHT_ATTACKS[index] & g.pieces[enemy][KNIGHT])
 	{
-		moves = Generate_Knight_Moves(g, index);
+		return true;
 	}
 
-	// If piece is a queen
-	else if (g.board[index] == 'Q' || g.board[index] == 'q')
+	if (KING_ATTACKS[index] & g.pieces[enemy][KING])
 	{
-		moves = Generate_Queen_Moves(g, index);
+		return true;
 	}
 
-	// If piece is a king
-	else if (g.board[index] == 'K' || g.board[index] == 'k')
+	// Sliders only need to be looked up if one of them could reach the square on an empty board
+	Bitboard diagonal = g.pieces[enemy][BISHOP] | g.pieces[enemy][QUEEN];
+	if (diagonal && (Bishop_Attacks(index, g.all_pieces) & diagonal))
 	{
-		moves = Generate_King_Moves(g, index, ignore_non_attacks);
+		return true;
 	}
-	else
+
+	Bitboard straight = g.pieces[enemy][ROOK] | g.pieces[enemy][QUEEN];
+	if (straight && (Rook_Attacks(index, g.all_pieces) & straight))
 	{
-		std::cout << "There is no piece on square " << Convert_to_Algebraic(index) << ".\n";
+		return true;
 	}
 
-	return moves;
+	// If we get here, then the square is not under attack
+	return false;
 }
 
-bool Square_Under_Attack(const Gamestate& g, const int index, const char player_color)
+Bitboard Attackers_To(const Gamestate& g, const int index, const Bitboard occupied)
 {
-	// Iterate over every square on the board
-	for (int i = 0 ; i < g.board.size(); i++)
+	Bitboard diagonal = g.pieces[WHITE][BISHOP] | g.pieces[BLACK][BISHOP] | g.pieces[WHITE][QUEEN] | g.pieces[BLACK][QUEEN];
+	Bitboard straight = g.pieces[WHITE][ROOK] | g.pieces[BLACK][ROOK] | g.pieces[WHITE][QUEEN] | g.pieces[BLACK][QUEEN];
+
+	// Same idea as Square_Under_Attack(), but collecting every attacker. White pawns attack the
+	// square from where a black pawn on it would attack, and the other way around
+	return (PAWN_ATTACKS[BLACK][index] & g.pieces[WHITE][PAWN])
+		 | (PAWN_ATTACKS[WHITE][index] & g.pieces[BLACK][PAWN])
+		 | (KNIGHT_ATTACKS[index] & (g.pieces[WHITE][KNIGHT] | g.pieces[BLACK][KNIGHT]))
+		 | (KING_ATTACKS[index] & (g.pieces[WHITE][KING] | g.pieces[BLACK][KING]))
+		 | (Bishop_Attacks(index, occupied) & diagonal)
+		 | (Rook_Attacks(index, occupied) & straight);
+}
+
+int Castling_Mask(const int index)
+{
+	// Moving a king or rook off its starting square, or capturing a rook on it, removes those castles
+	switch (index)
 	{
-		// If there is a piece
-		if (g.board[i] != ' ')
-		{
-			// If the piece is an enemy
-			if ((player_color == 'w' && islower(g.board[i])) || (player_color == 'b' && isupper(g.board[i])))
-			{
-				// Generate every valid move for that piece, ignoring straight pawn moves, en passant moves, and castling
-				std::vector<std::string> moves = Generate_Piece_Moves(g, i, true);
-
-				// std::cout << "All attacking moves for " << g.board[i] << " on " << Convert_to_Algebraic(i) << ":" << std::endl;
-				// for (int n = 0; n < moves.size(); n++)
-				// {
-				// 	std::cout << moves[n] << std::endl;
-				// }
-
-				// Check if the ending square of any of those moves is our index square
-				for (int j = 0; j < moves.size(); j++)
-				{
-					// Get the target square from the move (characters 3 & 4)
-					std::string target = moves[j].substr(2,2);
-					// std::cout << "target: " << target << std::endl;
-
-					if (target == Convert_to_Algebraic(index))
-					{
-						// The index square is under attack
-						return true;
-					}
-				}
-			}
-		}
+		case 0: return ~WHITE_QUEENSIDE;					// a1
+		case 4: return ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);	// e1
+		case 7: return ~WHITE_KINGSIDE;						// h1
+		case 56: return ~BLACK_QUEENSIDE;					// a8
+		case 60: return ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);	// e8
+		case 63: return ~BLACK_KINGSIDE;					// h8
+		default: return ~0;
 	}
-
-	// If we get here, then the square is not under attack
-	return false;
 }
 
-Gamestate Simulate_Move(const Gamestate& g, const std::string move)
+void Make_Move(Gamestate& g, const Move move, Undo_Record& undo)
 {
-	// Check if a move was given
-	if (move.length() < 4)
+	// Unpack the start square, target square, and the kind of move
+	int src_sq = Move_From(move);
+	int dest_sq = Move_To(move);
+	int flags = Move_Flags(move);
+
+	char piece = g.board[src_sq];
+	int color = Piece_Color(piece);
+
+	// En passant captures the pawn that is behind the target square
+	int capture_sq = (flags == EP_CAPTURE ? dest_sq + (color == WHITE ? S : N) : dest_sq);
+
+	// Save everything that cannot be worked out again from the move itself
+	undo.captured = g.board[capture_sq];
+	undo.castling_rights = g.castling_rights;
+	undo.en_passant_square = g.en_passant_square;
+	undo.halfmove_clock = g.halfmove_clock;
+	undo.hash_key = g.hash_key;
+
+	// Remember the position before the move, to spot it if it comes up again
+	g.key_history[g.history_length % KEY_HISTORY_SIZE] = g.hash_key;
+	g.history_length++;
+
+	// The old castles and en passant target are hashed out here and the new ones hashed in below.
+	// Pieces are hashed in and out by Add_Piece() and Remove_Piece()
+	g.hash_key ^= ZOBRIST_CASTLING[g.castling_rights];
+	if (g.en_passant_square != -1)
 	{
-		std::cout << "\nInvalid move given to Simulate_Move()!\n";
-		exit(1);
+		g.hash_key ^= ZOBRIST_EN_PASSANT[g.en_passant_square % 8];
 	}
 
-	// Create a copy of the gamestate
-	Gamestate new_state(g);
-
-	// Start square is first 2 chars, target square are the next 2, and promotion if needed is the last
-	// Convert the squares to board indicies to be used later
-	int src_sq = Convert_to_Index(move.substr(0,2));
-	int dest_sq = Convert_to_Index(move.substr(2,move.length()-2));
-
 
 	//// Update the board ////
 
-	// Check if this is a promotion move
-	// std::cout << "Source: " << g.board[src_sq] << std::endl;
-	// std::cout << "Move 3: " << move[3] << std::endl;
-	// std::cout << "Move 4: " << move[1] << std::endl;
-
+	// Any captured piece leaves the board, and the src_sq becomes empty
+	g.Remove_Piece(capture_sq);
+	g.Remove_Piece(src_sq);
 
-	if (g.board[src_sq] == 'P' && move[3] == '8')
-	{
-		// White promotion
-		new_state.board[dest_sq] = char(std::toupper(move[4]));
-	}
-	else if (g.board[src_sq] == 'p' && move[3] == '1')
+	// Check if this is a promotion move
+	if (Is_Promotion(move))
 	{
-		// Black promotion
-		new_state.board[dest_sq] = char(std::tolower(move[4]));
+		// Replace the pawn with the promotion piece of the same color
+		g.Add_Piece(PIECE_CHARS[color][Promotion_Type(move)], dest_sq);
 	}
 	else
 	{
 		// Not a promotion
-		// Copy the contents of the src_sq to the dest_sq
-		new_state.board[dest_sq] = new_state.board[src_sq];
-		// std::cout << "No promo this time.\n";
+		// Move the piece from the src_sq to the dest_sq
+		g.Add_Piece(piece, dest_sq);
 	}
 
-	// The src_sq then becomes empty
-	new_state.board[src_sq] = ' ';
+	// Castling also moves the rook to the other side of the king
+	if (flags == KING_CASTLE)
+	{
+		g.Remove_Piece(src_sq + 3);
+		g.Add_Piece(PIECE_CHARS[color][ROOK], src_sq + 1);
+	}
+	else if (flags == QUEEN_CASTLE)
+	{
+		g.Remove_Piece(src_sq - 4);
+		g.Add_Piece(PIECE_CHARS[color][ROOK], src_sq - 1);
+	}
 
 
 	//// Other state variables ////
 
 	/* Whose turn next */
-	new_state.next_turn = (isupper(new_state.board[dest_sq]) ? 'b' : 'w');
-
+	g.next_turn = (color == WHITE ? 'b' : 'w');
+	g.hash_key ^= ZOBRIST_BLACK_TO_MOVE;
 
 	/* Which castles are still available */
-	std::string new_castles = "";
+	// A castle stays available as long as neither its king nor its rook has moved or been captured
+	g.castling_rights &= Castling_Mask(src_sq) & Castling_Mask(dest_sq);
+	g.hash_key ^= ZOBRIST_CASTLING[g.castling_rights];
 
-	for (int i = 0; i < g.castles.length(); i++)
+	/* Which square is en passant target */
+	// If the move is a 2-square pawn move, the target is the square the pawn skipped over
+	g.en_passant_square = (flags == DOUBLE_PAWN_PUSH ? (src_sq + dest_sq) / 2 : -1);
+	if (g.en_passant_square != -1)
 	{
-		// Castle is still valid if:
-		// 1. It was valid in the last gamestate
-		// 2. The king is not moving
-		// 3. The corresponding side's rook is still alive and not moving
-
-		// White kingside:
-		// 1. //
-		if (g.castles[i] == 'K')
-		{
-			// 2. //
-			if (move[0] != 'e' || move[1] != '1')
-			{
-				// 3. //
-				if ((move[0] != 'h' || move[1] != '1') && new_state.board[Convert_to_Index("h1")] == 'R')
-				{
-					// All conditions satisfied, this castle is possible
-					new_castles += 'K';
-				}
-			}
-		}
-
-		// White queenside:
-		else if (g.castles[i] == 'Q')
-		{
-			if (move[0] != 'e' || move[1] != '1')
-			{
-				if ((move[0] != 'a' || move[1] != '1') && new_state.board[Convert_to_Index("a1")] == 'R')
-				{
-					// All conditions satisfied, this castle is possible
-					new_castles += 'Q';
-				}
-			}
-		}
-
-		// Black kingside:
-		else if (g.castles[i] == 'k')
-		{
-			if (move[0] != 'e' || move[1] != '8')
-			{
-				if ((move[0] != 'h' || move[1] != '8') && new_state.board[Convert_to_Index("h8")] == 'r')
-				{
-					// All conditions satisfied, this castle is possible
-					new_castles += 'k';
-				}
-			}
-		}
+		g.hash_key ^= ZOBRIST_EN_PASSANT[g.en_passant_square % 8];
+	}
 
-		// Black queenside
-		else if (g.castles[i] == 'q')
-		{
-			if (move[0] != 'e' || move[1] != '8')
-			{
-				if ((move[0] != 'a' || move[1] != '8') && new_state.board[Convert_to_Index("a8")] == 'r')
-				{
-					// All conditions satisfied, this castle is possible
-					new_castles += 'q';
-				}
-			}
-		}
+	/* Update halfmove clock */
+	// Reset if this is a capturing move or a pawn move/promotion, otherwise increment the clock
+	if (Is_Capture(move) || Piece_Type(piece) == PAWN)
+	{
+		g.halfmove_clock = 0;
+	}
+	else
+	{
+		g.halfmove_clock++;
 	}
 
-	// Check if no castles are available
-	if (new_castles == "")
+	/* Update fullmove counter */
+	// Increment if its white's turn next
+	if (g.next_turn == 'w')
 	{
-		new_castles = "-";
+		g.fullmove_counter++;
 	}
+}
 
-	// Update the new state
-	new_state.castles = new_castles;
+void Unmake_Move(Gamestate& g, const Move move, const Undo_Record& undo)
+{
+	// Unpack the start square, target square, and the kind of move
+	int src_sq = Move_From(move);
+	int dest_sq = Move_To(move);
+	int flags = Move_Flags(move);
 
+	// The player who made the move is the one who is not up next
+	int color = (g.next_turn == 'w' ? BLACK : WHITE);
 
-	/* Which square is en passant target */
-	// Check if the move is a 2-square pawn move
-	bool ep_move = false;
 
-	if (new_state.board[dest_sq] == 'P')
-	{
-		// White 2-sq move
-		if (move[1] == '2' && move[3] == '4')
-		{
-			ep_move = true;
+	//// Restore the board ////
 
-			// White pawn moved 2, so the en passant square is one rank MORE than the source
-			std::string white_ep = "";
-			white_ep += char(move[0]);
-			white_ep += char(move[1] + 1);
-			new_state.en_passant_target = white_ep;
-		}
-	}
-	else if (new_state.board[dest_sq] == 'p')
-	{
-		// Black 2-sq move
-		if (move[1] == '7' && move[3] == '5')
-		{
-			ep_move = true;
+	// Take the moved piece back to the src_sq, turning promotions back into pawns
+	char piece = (Is_Promotion(move) ? PIECE_CHARS[color][PAWN] : g.board[dest_sq]);
+	g.Remove_Piece(dest_sq);
+	g.Add_Piece(piece, src_sq);
 
-			// Black pawn moved 2, so the en passant target is one rank LESS than the source
-			std::string black_ep = "";
-			black_ep += char(move[0]);
-			black_ep += char(move[1] - 1);
-			new_state.en_passant_target = black_ep;
-		}
-	}
-	
-	// No 2-sq move
-	if (!ep_move)
+	// Put back any captured piece
+	if (undo.captured != ' ')
 	{
-		new_state.en_passant_target = "-";
+		g.Add_Piece(undo.captured, (flags == EP_CAPTURE ? dest_sq + (color == WHITE ? S : N) : dest_sq));
 	}
 
-
-	/* Update halfmove clock */
-	// Reset if this is a capturing move
-	if ((isupper(g.board[src_sq]) && islower(g.board[dest_sq])) || (islower(g.board[src_sq]) && isupper(g.board[dest_sq])))
+	// Put a castled rook back in its corner
+	if (flags == KING_CASTLE)
 	{
-		new_state.halfmove_clock = 0;
+		g.Remove_Piece(src_sq + 1);
+		g.Add_Piece(PIECE_CHARS[color][ROOK], src_sq + 3);
 	}
-	// Reset if this is a pawn move/promotion
-	else if  (g.board[src_sq] == 'P' || g.board[src_sq] == 'p')
+	else if (flags == QUEEN_CASTLE)
 	{
-		new_state.halfmove_clock = 0;
-	}
-	// Otherwise increment the clock
-	else
-	{
-		new_state.halfmove_clock = g.halfmove_clock + 1;
+		g.Remove_Piece(src_sq - 1);
+		g.Add_Piece(PIECE_CHARS[color][ROOK], src_sq - 4);
 	}
 
 
-	/* Update fullmove counter */
-	// Increment if its white's turn next
-	if (new_state.next_turn == 'w')
+	//// Other state variables ////
+
+	g.next_turn = (color == WHITE ? 'w' : 'b');
+	g.castling_rights = undo.castling_rights;
+	g.en_passant_square = undo.en_passant_square;
+	g.halfmove_clock = undo.halfmove_clock;
+
+	// Restoring the pieces hashed them back, but the saved key also covers the rest of the state
+	g.hash_key = undo.hash_key;
+
+	if (color == BLACK)
 	{
-		new_state.fullmove_counter = g.fullmove_counter + 1;
+		g.fullmove_counter--;
 	}
-	// Else copy the value
-	else
+
+	// The position before the move is the current one again
+	g.history_length--;
+}
+
+void Make_Null_Move(Gamestate& g, Undo_Record& undo)
+{
+	// Only the turn and the en passant target change
+	undo.en_passant_square = g.en_passant_square;
+	undo.halfmove_clock = g.halfmove_clock;
+	undo.hash_key = g.hash_key;
+
+	// Keep the key history in step with the turns, but do not look back past the null move for
+	// repetitions, since it is not a real move
+	g.key_history[g.history_length % KEY_HISTORY_SIZE] = g.hash_key;
+	g.history_length++;
+	g.halfmove_clock = 0;
+
+	if (g.en_passant_square != -1)
 	{
-		new_state.fullmove_counter = g.fullmove_counter;
+		g.hash_key ^= ZOBRIST_EN_PASSANT[g.en_passant_square % 8];
+		g.en_passant_square = -1;
 	}
 
+	g.next_turn = (g.next_turn == 'w' ? 'b' : 'w');
+	g.hash_key ^= ZOBRIST_BLACK_TO_MOVE;
+}
 
-	/* Track the last 8 moves */
-	new_state.last_eight_moves = g.last_eight_moves;
+void Unmake_Null_Move(Gamestate& g, const Undo_Record& undo)
+{
+	g.next_turn = (g.next_turn == 'w' ? 'b' : 'w');
+	g.en_passant_square = undo.en_passant_square;
+	g.halfmove_clock = undo.halfmove_clock;
+	g.hash_key = undo.hash_key;
+	g.history_length--;
+}
 
-	// Keep the list size to 8
-	if (new_state.last_eight_moves.size() >= 8)
+Gamestate Simulate_Move(const Gamestate& g, const Move move)
+{
+	// Check if a move was given
+	if (move == NULL_MOVE)
 	{
-		// Remove the oldest move
-		new_state.last_eight_moves.erase(new_state.last_eight_moves.begin());
+		std::cout << "\nInvalid move given to Simulate_Move()!\n";
+		exit(1);
 	}
 
-	// Add the new half move
-	new_state.last_eight_moves.push_back(move);
+	// Create a copy of the gamestate, then make the move on it
+	Gamestate new_state(g);
+	Undo_Record undo;
+	Make_Move(new_state, move, undo);
 
 	// Return the updated state
 	return new_state;
 }
 
-std::string Get_Random_Move(const std::vector<std::string> all_moves)
+Move Parse_Move(const Gamestate& g, const std::string uci)
+{
+	// Find the valid move that is written the same way
+	Move_List valid_moves = Generate_Player_Moves(g, g.next_turn);
+	for (int i = 0; i < valid_moves.size(); i++)
+	{
+		if (Move_to_UCI(valid_moves[i]) == uci)
+		{
+			return valid_moves[i];
+		}
+	}
+
+	// No valid move matches
+	return NULL_MOVE;
+}
+
+Move Get_Random_Move(const Move_List& all_moves)
+
 {
 	// Seed random
 	srand(time(NULL));
@@ -1179,115 +900,73 @@ std::string Get_Random_Move(const std::vector<std::string> all_moves)
 	return all_moves[i];
 }
 
-bool Game_Draw(const Gamestate& g)
+void Get_Node_Status(const Gamestate& g, Node_Status& status)
 {
-	// A draw occurs when:
+	// Generate the moves once, finding out if the player is in check along the way
+	status.valid_moves.clear();
+	status.in_check = (Generate_Legal_Moves(g, (g.next_turn == 'w' ? WHITE : BLACK), status.valid_moves) != 0);
 
-	// 1. The last eight moves have not had a capture or pawn move (halfmove clock >= 16)
-	// AND
-	// 2. The first half of the last eight moves are identical to the last half of the last eight moves
+	// With no moves left, the game is over one way or the other
+	bool no_moves = status.valid_moves.empty();
+	status.checkmate = no_moves && status.in_check;
+	status.stalemate = no_moves && !status.in_check;
 
-	// OR
-	// 3. The player who is up next does not have any valid moves and is not checkmated
-
-	// OR
-	// 4. There is not enough material for either player to checkmate // todo
-
-	bool draw_conditions = true;
+	status.draw_conditions = Draw_Conditions(g);
+	status.insufficient_material = Insufficient_Material(g);
+}
 
-	// 1. Check the halfmove clock
-	if (g.halfmove_clock < 16)
-	{
-		draw_conditions = false;
-	}
+bool Draw_Conditions(const Gamestate& g)
+{
+	// A draw occurs when:
 
-	// 2. Check the last 8 halfmoves
-	if (g.last_eight_moves.size() != 8)
+	// 1. Fifty moves by each player have gone by without a capture or pawn move
+	if (g.halfmove_clock >= 100)
 	{
-		// Not enough moves in the queue
-		draw_conditions = false;
-	}
-	else
-	{
-		// Check each pair for differences
-		for (int i = 0; i < 4; i++)
-		{
-			if (g.last_eight_moves[i] != g.last_eight_moves[i+4])
-			{
-				draw_conditions = false;
-				break;
-			}
-		}
+		return true;
 	}
 
+	// OR
+	// 2. The same position (same pieces, player to move, castles, and en passant) comes up for
+	// the third time
+	return g.Repetition_Count() >= 2;
+}
 
-	// 3. Check if the game is not checkmate and the next player has no valid moves
-	bool no_moves = !Game_Checkmate(g) && Generate_Player_Moves(g, g.next_turn).empty();
+bool Game_Draw(const Gamestate& g)
+{
+	// A draw occurs when:
 
+	// 1. The fifty-move rule or the threefold repetition rule applies (see Draw_Conditions())
 
-	// 4. There is not enough material to checkmate
-	bool insufficient_material = Insufficient_Material(g);
+	// OR
+	// 2. The player who is up next does not have any valid moves and is not checkmated
 
+	// OR
+	// 3. There is not enough material for either player to checkmate
 
-	// Put it all together
-	bool draw = draw_conditions || no_moves || insufficient_material;
+	// Cheap checks first, so the moves only need to be generated if nothing else applies
+	if (Draw_Conditions(g) || Insufficient_Material(g))
+	{
+		return true;
+	}
 
-	return draw;
+	Node_Status status;
+	Get_Node_Status(g, status);
+	return status.stalemate;
 }
 
 std::string Draw_Type(const Gamestate& g)
 {
-	bool draw_conditions = true;
-
-	// 1. Check the halfmove clock
-	if (g.halfmove_clock < 16)
-	{
-		draw_conditions = false;
-	}
-
-	// 2. Check the last 8 halfmoves
-	if (g.last_eight_moves.size() != 8)
-	{
-		// Not enough moves in the queue
-		draw_conditions = false;
-	}
-	else
-	{
-		// Check each pair for differences
-		for (int i = 0; i < 4; i++)
-		{
-			if (g.last_eight_moves[i] != g.last_eight_moves[i+4])
-			{
-				draw_conditions = false;
-				break;
-			}
-		}
-	}
-
-
-	// 3. Check if the game is not checkmate and the next player has no valid moves
-	bool no_moves = !Game_Checkmate(g) && Generate_Player_Moves(g, g.next_turn).empty();
-
-
-	// 4. There is not enough material to checkmate
-	bool insufficient_material = Insufficient_Material(g);
+	Node_Status status;
+	Get_Node_Status(g, status);
 
 	// Return whichever triggered first
-	return (draw_conditions ? "Draw Conditions." : (no_moves ? "No Moves." : "Insufficient Material!"));
+	return (status.draw_conditions ? "Draw Conditions." : (status.stalemate ? "No Moves." : "Insufficient Material!"));
 }
 
 bool White_Checkmated(const Gamestate& g)
 {
 	// Get the position of the white king
-	int king_index = 0;
-
-	for (int i = 0; i < g.board.size(); i++)
-	{
-		if (g.board[i] == 'K')
-		{
-			king_index = i;
-		}
-	}
+	int king_index = g.King_Square(WHITE);
 
 	// Check if the king is under attack
 	bool mated = false;
@@ -1307,15 +986,7 @@ bool White_Checkmated(const Gamestate& g)
 bool Black_Checkmated(const Gamestate& g)
 {
 	// Get the position of the black king
-	int king_index = 0;
-
-	for (int i = 0; i < g.board.size(); i++)
-	{
-		if (g.board[i] == 'k')
-		{
-			king_index = i;
-		}
-	}
+	int king_index = g.King_Square(BLACK);
 
 	// Check if the king is under attack
 	bool mated = false;
@@ -1334,102 +1005,43 @@ bool Black_Checkmated(const Gamestate& g)
 
 bool Game_Checkmate(const Gamestate& g)
 {
-	return g.next_turn == 'w' ? White_Checkmated(g) : Black_Checkmated(g);
+	Node_Status status;
+	Get_Node_Status(g, status);
+	return status.checkmate;
 }
 
 bool Insufficient_Material(const Gamestate& g)
 {
-	bool insufficient_material = true;
-
-	int knights = 0;
-	int light_bishops = 0;
-	int dark_bishops = 0;
-
-	// Check every square on the board
-	for (int i = 0; i < g.board.size(); i++)
+	// Pawns (eventually), rooks, and queens can always cause checkmate
+	for (int color = 0; color < 2; color++)
 	{
-		// Queen can cause checkmate
-		if (g.board[i] == 'Q' || g.board[i] == 'q')
-		{
-			insufficient_material = false;
-			break;
-		}
-
-		// Rook can cause checkmate
-		else if (g.board[i] == 'R' || g.board[i] == 'r')
-		{
-			insufficient_material = false;
-			break;
-		}
-
-		// Pawn can cause checkmate (eventually)
-		else if (g.board[i] == 'P' || g.board[i] == 'p')
+		if (g.pieces[color][PAWN] | g.pieces[color][ROOK] | g.pieces[color][QUEEN])
 		{
-			insufficient_material = false;
-			break;
-		}
-
-		// Knights need at least 2
-		else if (g.board[i] == 'N' || g.board[i] == 'n')
-		{
-			knights++;
-			if (knights >= 2)
-			{
-				insufficient_material = false;
-				break;
-			}
+			return false;
 		}
+	}
 
-		// Bishops need at least 2, and also at least one pair of opposite color square
-		else if (g.board[i] == 'B' || g.board[i] == 'b')
-		{
-			// Check if the rank is even
-			char c = Convert_to_Algebraic(i)[1];
-			if (c == '2' || c == '4' || c == '6' || c == '8')
-			{
-				// Square index % 2 == 0 for dark squares on even ranks
-				if (i % 2 == 0)
-				{
-					dark_bishops++;
-				}
-				// Square index % 2 == 1 for light squares on even ranks
-				else
-				{
-					light_bishops++;
-				}
-			}
-			// Else it's on an odd rank
-			else
-			{
-				// Square index % 2 == 1 for dark squares on odd ranks
-				if (i % 2 == 1)
-				{
-					dark_bishops++;
-				}
-				// Square index % 2 == 0 for light squares on odd ranks
-				else
-				{
-					light_bishops++;
-				}
-			}
+	// Knights need at least 2
+	int knights = Pop_Count(g.pieces[WHITE][KNIGHT] | g.pieces[BLACK][KNIGHT]);
+	if (knights >= 2)
+	{
+		return false;
+	}
 
-			// Check if there's enough to checkmate
-			if (light_bishops != 0 && dark_bishops != 0)
-			{
-				insufficient_material = false;
-				break;
-			}
-		}
+	// Bishops need at least one pair on opposite color squares
+	Bitboard bishops = g.pieces[WHITE][BISHOP] | g.pieces[BLACK][BISHOP];
+	if ((bishops & DARK_SQUARES) && (bishops & ~DARK_SQUARES))
+	{
+		return false;
+	}
 
-		// 1 bishop and 1 knight can cause checkmate
-		if ((light_bishops + dark_bishops) != 0 && knights != 0)
-		{
-			insufficient_material = false;
-			break;
-		}
+	// 1 bishop and 1 knight can cause checkmate
+	if (bishops && knights != 0)
+	{
+		return false;
 	}
 
-	return insufficient_material;
+	return true;
 }
 
 
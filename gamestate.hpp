@@ -1,25 +1,53 @@
 #ifndef GAMESTATE_HPP
 #define GAMESTATE_HPP
 
+#include "bitboard.hpp"
+#include "move.hpp"
+#include "zobrist.hpp"
+#include "piece_square.hpp"
+
 #include <vector>
 #include <cstdlib> // isdigit
 #include <sstream> // stringstream
 
 
+// Number of earlier position keys Gamestate keeps. Only positions since the last capture or pawn
+// move can repeat, and the fifty-move rule ends the game before 100 of those, so this only has to
+// cover that plus the deepest search
+const int KEY_HISTORY_SIZE = 256;
+
+// Bits of Gamestate::castling_rights for each castle that is still available
+const int WHITE_KINGSIDE = 1;		// 'K'
+const int WHITE_QUEENSIDE = 2;		// 'Q'
+const int BLACK_KINGSIDE = 4;		// 'k'
+const int BLACK_QUEENSIDE = 8;		// 'q'
+
 class Gamestate
 {
 public:
-	std::vector<char> board;		// squares are indexed 0-63 from bottom left to top right, each piece 
+	char board[64];						// squares are indexed 0-63 from bottom left to top right, each piece 
 										// is represented by a different character ex) 'k' = black king, 'N' = white knight
 
+	Bitboard pieces[2][6];				// one bitboard per piece type and color, indexed [WHITE/BLACK][PAWN-KING]
+	Bitboard occupancy[2];				// every square occupied by each color
+	Bitboard all_pieces;				// every occupied square
+
 	char next_turn;						// 'w' = white, 'b' = black
-	std::string castles;				// castles available to each player ex) "KQkq" or "Kq"
-	std::string en_passant_target;		// where en passant is possible ex) "c3" or "-"
+	int castling_rights;				// castles available to each player, a combination of the *_KINGSIDE/*_QUEENSIDE bits
+	int en_passant_square;				// square index where en passant is possible, or -1 if there is none
+
+	uint64_t hash_key;					// Zobrist key of the position (pieces, next turn, castles, en passant file)
+
+	int mg_score;						// material and square bonuses of every piece for the middlegame and
+	int eg_score;						// endgame, from white's point of view (see piece_square.hpp)
+	int phase;							// sum of PHASE_WEIGHTS over every piece, MAX_PHASE at the start
 
 	int halfmove_clock;					// halfmoves since last capture, promotion, or pawn move
 	int fullmove_counter;				// current turn
 
-	std::vector<std::string> last_eight_moves;	// last eight half moves made (UCI format)
+	uint64_t key_history[KEY_HISTORY_SIZE];	// hash_key before each move made from the FEN, in order, wrapping
+											// around so entry (n % KEY_HISTORY_SIZE) is the key before move n
+	int history_length;					// number of moves made since the FEN (entries pushed to key_history)
 
 	// Default constructor uses start state FEN
 	Gamestate()
@@ -30,20 +58,9 @@ public:
 		*this = temp;
 	}
 
-	// Copy constructor
-	Gamestate(const Gamestate& g)
-	{
-		board = g.board;
-
-		next_turn = g.next_turn;
-		castles = g.castles;
-		en_passant_target = g.en_passant_target;
-
-		halfmove_clock = g.halfmove_clock;
-		fullmove_counter = g.fullmove_counter;
-
-		last_eight_moves = g.last_eight_moves;
-	}
+	// The implicit copy constructor and assignment operator copy every member. Every member is
+	// a fixed-size value, so copying a Gamestate never allocates memory (but does copy the whole
+	// key history, so search by making and unmaking moves rather than copying)
 
 	// Constructor from given FEN string
 	Gamestate(const std::string fen_string)
@@ -58,11 +75,29 @@ public:
 		// splits[4] = halfmove clock
 		// splits[5] = current turn
 
-		// Start the board off with all spaces
+		// Make sure the attack, hash key, and evaluation tables exist before any position is used
+		Init_Bitboards();
+		Init_Zobrist();
+		Init_Piece_Square_Tables();
+
+		// Start the board off with all spaces and empty bitboards
 		for (int i = 0; i < 64; i++)
 		{
-			board.push_back(' ');
+			board[i] = ' ';
+		}
+		for (int color = 0; color < 2; color++)
+		{
+			for (int type = 0; type < 6; type++)
+			{
+				pieces[color][type] = 0;
+			}
+			occupancy[color] = 0;
 		}
+		all_pieces = 0;
+		hash_key = 0;
+		mg_score = 0;
+		eg_score = 0;
+		phase = 0;
 
 		// Split the string at each space character
 		std::vector<std::string> splits;
@@ -98,8 +133,8 @@ public:
 				// Otherwise the character must represent a piece
 				else
 				{
-					// Add the piece's character to the board data and move to the next square over
-					board[rank * 8 + file] = symbol;
+					// Add the piece to the board data and move to the next square over
+					Add_Piece(symbol, rank * 8 + file);
 					file++;
 				}
 			}
@@ -107,25 +142,143 @@ public:
 
 		// FEN contains information for other state variables as well
 		next_turn = splits[1][0];
-		castles = splits[2];
-		en_passant_target = splits[3];
+
+		// Castling availabilities are some combination of "KQkq", or "-" for none
+		castling_rights = 0;
+		for (int i = 0; i < splits[2].length(); i++)
+		{
+			switch (splits[2][i])
+			{
+				case 'K': castling_rights |= WHITE_KINGSIDE; break;
+				case 'Q': castling_rights |= WHITE_QUEENSIDE; break;
+				case 'k': castling_rights |= BLACK_KINGSIDE; break;
+				case 'q': castling_rights |= BLACK_QUEENSIDE; break;
+			}
+		}
+
+		// En passant target is an algebraic square ex) "c3", or "-" for none
+		if (splits[3] == "-")
+		{
+			en_passant_square = -1;
+		}
+		else
+		{
+			en_passant_square = (splits[3][1] - '1') * 8 + (splits[3][0] - 'a');
+		}
+
 		halfmove_clock = atoi(splits[4].c_str());
 		fullmove_counter = atoi(splits[5].c_str());
+
+		// No moves have been made from this position yet
+		history_length = 0;
+
+		// The pieces were hashed as they were added, so hash in the rest of the state
+		if (next_turn == 'b')
+		{
+			hash_key ^= ZOBRIST_BLACK_TO_MOVE;
+		}
+		hash_key ^= ZOBRIST_CASTLING[castling_rights];
+		if (en_passant_square != -1)
+		{
+			hash_key ^= ZOBRIST_EN_PASSANT[en_passant_square % 8];
+		}
 	}
 
-	// Overload assignment operator to deep copy class objects
-	void operator =(const Gamestate& g)
+	// Place a piece on an empty square, keeping the board, bitboards, hash key, and scores in sync
+	void Add_Piece(const char piece, const int index)
 	{
-		board = g.board;
+		int color = Piece_Color(piece);
+		int type = Piece_Type(piece);
+		Bitboard bb = Square_BB(index);
 
-		next_turn = g.next_turn;
-		castles = g.castles;
-		en_passant_target = g.en_passant_target;
+		board[index] = piece;
+		pieces[color][type] |= bb;
+		occupancy[color] |= bb;
+		all_pieces |= bb;
 
-		halfmove_clock = g.halfmove_clock;
-		fullmove_counter = g.fullmove_counter;
+		hash_key ^= ZOBRIST_PIECES[color][type][index];
 
-		last_eight_moves = g.last_eight_moves;
+		mg_score += PSQT_MG[color][type][index];
+		eg_score += PSQT_EG[color][type][index];
+		phase += PHASE_WEIGHTS[type];
+	}
+
+	// Take whatever piece is on the given square off the board
+	void Remove_Piece(const int index)
+	{
+		char piece = board[index];
+		if (piece == ' ')
+		{
+			return;
+		}
+
+		int color = Piece_Color(piece);
+		int type = Piece_Type(piece);
+		Bitboard bb = Square_BB(index);
+
+		board[index] = ' ';
+		pieces[color][type] &= ~bb;
+		occupancy[color] &= ~bb;
+		all_pieces &= ~bb;
+
+		hash_key ^= ZOBRIST_PIECES[color][type][index];
+
+		mg_score -= PSQT_MG[color][type][index];
+		eg_score -= PSQT_EG[color][type][index];
+		phase -= PHASE_WEIGHTS[type];
+	}
+
+	// Get the square index of the given color's king (WHITE/BLACK), or -1 if there is none
+	int King_Square(const int color) const
+	{
+		Bitboard king = pieces[color][KING];
+		return (king ? LSB(king) : -1);
+	}
+
+	// Count how many times the current position has come up before. Positions before the last
+	// capture or pawn move (the halfmove clock) can never come up again, so only those after it
+	// are checked, and only every other one, since the same player has to be up next
+	int Repetition_Count() const
+	{
+		int count = 0;
+		int limit = (halfmove_clock < history_length ? halfmove_clock : history_length);
+
+		// The position 2 moves ago cannot be the same, since each player has moved a piece since
+		for (int i = 4; i <= limit; i += 2)
+		{
+			if (key_history[(history_length - i) % KEY_HISTORY_SIZE] == hash_key)
+			{
+				count++;
+			}
+		}
+
+		return count;
+	}
+
+	// Get the castling availabilities in FEN format ex) "KQkq", "Kq", or "-"
+	std::string Castles_String() const
+	{
+		std::string castles = "";
+		if (castling_rights & WHITE_KINGSIDE) castles += 'K';
+		if (castling_rights & WHITE_QUEENSIDE) castles += 'Q';
+		if (castling_rights & BLACK_KINGSIDE) castles += 'k';
+		if (castling_rights & BLACK_QUEENSIDE) castles += 'q';
+
+		return (castles == "" ? "-" : castles);
+	}
+
+	// Get the en passant target in FEN format ex) "c3" or "-"
+	std::string En_Passant_String() const
+	{
+		if (en_passant_square == -1)
+		{
+			return "-";
+		}
+
+		std::string square = "";
+		square += char('a' + en_passant_square % 8);
+		square += char('1' + en_passant_square / 8);
+		return square;
 	}
 
 	// Output the board data and other state variables to the console
@@ -150,14 +303,9 @@ public:
 		// Output other variables
 		std::cout << "Next Turn: " << fullmove_counter << "/" << next_turn << "\n";
 		std::cout << "Halfmove Clock: " << halfmove_clock << "\n";
-		std::cout << "Castles: " << castles << "\n";
-		std::cout << "En Passant: " << en_passant_target << "\n";
-		std::cout << "Last 8 Halfmoves: { ";
-		for (int i = 0; i < last_eight_moves.size(); i++)
-		{
-			std::cout << last_eight_moves[i] << (i != last_eight_moves.size() - 1 ? ", " : "");
-		}
-		std::cout << " }\n\n";
+		std::cout << "Castles: " << Castles_String() << "\n";
+		std::cout << "En Passant: " << En_Passant_String() << "\n";
+		std::cout << "Repetitions: " << Repetition_Count() << "\n\n";
 
 		return;
 	}
@@ -1,11 +1,28 @@
 #include <iostream>
+#include <string>
+#include <cstdlib> // atoi, atoll
+#include <chrono> // steady_clock
+#include <iomanip> // setprecision
 
 #include "gamestate.hpp"
 #include "game_logic.hpp"
 #include "algorithms.hpp"
+#include "perft.hpp"
 
 
-int main()
+// Search each of the given positions with both full-width minimax and alpha-beta negamax at the
+// same depth, and print the move, minimax score of that move, and node count of each
+void Compare_Search_Algorithms(const std::vector<std::string>& fens, const int depth_limit);
+
+// Search each of the given positions for a fixed time, and print the depth reached and node count
+void Run_Bench(const std::vector<std::string>& fens, const int64_t movetime);
+
+// Search each of the given positions to a fixed depth with 1, 2, 4, 8, and 16 threads, and print
+// how long each took and how much faster than one thread that was
+void Run_SMP_Bench(const std::vector<std::string>& fens, const int depth);
+
+
+int main(int argc, char* argv[])
 {	
 
 	std::string move_2 = "rnbqkbnr/ppp1pppp/8/3pP3/8/5N2/PPPP1PPP/RNBQKB1R b KQkq d6 1 2";
@@ -32,10 +49,10 @@ int main()
 	// std::cout << Convert_to_Algebraic(8) << "\n";
 	// std::cout << Convert_to_Index("a2") << "\n";
 	// std::cout << "Pawn moves:\n";
-	// std::vector<std::string> pawns = Generate_Pawn_Moves(from_fen, Convert_to_Index("b2"));
+	// std::vector<Move> pawns = Generate_Pawn_Moves(from_fen, Convert_to_Index("b2"));
 	// for (int i = 0; i < pawns.size(); i++)
 	// {
-	// 	std::cout << pawns[i] << "\n";
+	// 	std::cout << Move_to_UCI(pawns[i]) << "\n";
 	// }
 
 	std::string start_fen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
@@ -51,6 +68,71 @@ int main()
 
 	std::string mate_in_3 = "6nk/8/2Q4p/6R1/8/7K/8/8 w - - 0 2";
 
+	// "--no-null-move" and "--no-lmr" anywhere on the command line turn off those search techniques,
+	// to compare the search with and without them. "--threads <n>" searches with n threads
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--no-null-move")
+		{
+			SEARCH_OPTIONS.null_move_pruning = false;
+		}
+		else if (std::string(argv[i]) == "--no-lmr")
+		{
+			SEARCH_OPTIONS.late_move_reductions = false;
+		}
+		else if (std::string(argv[i]) == "--threads" && i + 1 < argc)
+		{
+			SEARCH_OPTIONS.threads = atoi(argv[i + 1]);
+		}
+	}
+
+	// "perft <depth> [fen]" counts the move tree below each root move of the given position
+	// (default start position), and "perft suite [depth]" checks the standard perft positions
+	if (argc > 2 && std::string(argv[1]) == "perft")
+	{
+		if (std::string(argv[2]) == "suite")
+		{
+			return (Run_Perft_Suite(argc > 3 ? atoi(argv[3]) : 4) ? 0 : 1);
+		}
+
+		Divide((argc > 3 ? std::string(argv[3]) : start_fen), atoi(argv[2]));
+		return 0;
+	}
+
+	// "compare [depth]" checks alpha-beta against full-width minimax instead of playing a game
+	if (argc > 1 && std::string(argv[1]) == "compare")
+	{
+		int depth_limit = (argc > 2 ? atoi(argv[2]) : 2);
+		Compare_Search_Algorithms({start_fen, move_2, pawn_promo, move_12, pawn_attacked, mate_in_2, rook_weird, mate_in_3}, depth_limit);
+		return 0;
+	}
+
+	// "bench [movetime_ms]" searches some middlegame positions for a fixed time each
+	if (argc > 1 && std::string(argv[1]) == "bench")
+	{
+		int64_t movetime = (argc > 2 && argv[2][0] != '-' ? atoll(argv[2]) : 5000);
+		Run_Bench({start_fen, move_2, move_12, pawn_attacked, PERFT_SUITE[1].fen, PERFT_SUITE[5].fen}, movetime);
+		return 0;
+	}
+
+	// "smp [depth]" measures how much faster helper threads make the search reach a fixed depth
+	if (argc > 1 && std::string(argv[1]) == "smp")
+	{
+		int depth = (argc > 2 && argv[2][0] != '-' ? atoi(argv[2]) : 8);
+		Run_SMP_Bench({start_fen, move_2, move_12, pawn_attacked, PERFT_SUITE[1].fen, PERFT_SUITE[5].fen}, depth);
+		return 0;
+	}
+
+	// "clock <time_ms> [increment_ms]" plays the game with both players on a real clock instead
+	// of searching to a fixed depth every move
+	Search_Limits limits;
+	bool timed_game = (argc > 2 && std::string(argv[1]) == "clock");
+	if (timed_game)
+	{
+		limits.wtime = limits.btime = atoll(argv[2]);
+		limits.winc = limits.binc = (argc > 3 ? atoll(argv[3]) : 0);
+	}
+
 	Gamestate game_state(start_fen);
 	game_state.Print();
 	std::cout << "\n-------STARTING THE GAME!!!-------\n\n";
@@ -60,7 +142,7 @@ int main()
 	int count = 0;
 	while (!stop)
 	{
-		std::string new_move = "";
+		Move new_move = NULL_MOVE;
 
 		// Check if we have reached the end of the game
 		if (Game_Draw(game_state))	// Draw
@@ -85,6 +167,9 @@ int main()
 		{
 			std::cout << "\n---------- TURN: " << game_state.fullmove_counter << " / " << game_state.next_turn << " ----------\n";
 
+			// Time the move so it can be taken off the player's clock
+			auto move_start = std::chrono::steady_clock::now();
+
 			// // Get moves for white via ID_DL_Minimax
 			// if (game_state.next_turn == 'w')	// White's move
 			// {
@@ -94,50 +179,66 @@ int main()
 			// // Use a set of given moves for white
 			// if (game_state.next_turn == 'w')
 			// {
-			// 	new_move = "g6g7";
+			// 	new_move = Parse_Move(game_state, "g6g7");
 			// }
 
 			// // Get moves for white randomly
 			// if (game_state.next_turn == 'w')
 			// {
-			// 	std::vector<std::string> all_white = Generate_Player_Moves(game_state, 'w');
+			// 	std::vector<Move> all_white = Generate_Player_Moves(game_state, 'w');
 			// 	new_move = Get_Random_Move(all_white);
 			// }
 
 			// Get moves for white via DL_Minimax
 			if (game_state.next_turn == 'w')
 			{
-				new_move = ID_DL_Minimax(game_state);
+				new_move = ID_DL_Minimax(game_state, limits);
 				// new_move = DL_Minimax_Choice(game_state, 1);
 			}
 
 			// // Use a set of given moves for black
 			// else
 			// {
-			// 	new_move = "f3g2";
+			// 	new_move = Parse_Move(game_state, "f3g2");
 			// }
 
 			// // Get moves for black randomly
 			// else
 			// {
-			// 	std::vector<std::string> all_black = Generate_Player_Moves(game_state, 'b');
+			// 	std::vector<Move> all_black = Generate_Player_Moves(game_state, 'b');
 			// 	new_move = Get_Random_Move(all_black);
 			// }
 
 			// Get moves for black via DL_Minimax
 			else
 			{
-				new_move = ID_DL_Minimax(game_state);
+				new_move = ID_DL_Minimax(game_state, limits);
 				// new_move = DL_Minimax_Choice(game_state, 1);
 			}
+
+			// Charge the player for the move, then give them their increment
+			if (timed_game)
+			{
+				int64_t used = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - move_start).count();
+				int64_t& clock = (game_state.next_turn == 'w' ? limits.wtime : limits.btime);
+				clock -= used;
+				if (clock <= 0)
+				{
+					std::cout << "\n-------GAME OVER!!!-------\n";
+					std::cout << "Player " << game_state.next_turn << " ran out of time!\n";
+					break;
+				}
+				clock += (game_state.next_turn == 'w' ? limits.winc : limits.binc);
+				std::cout << "Used " << used << " ms, clocks: w " << limits.wtime << " ms / b " << limits.btime << " ms\n";
+			}
 		}
 
 		// // Figure out what the best move is for this state
-		// std::string best_move = DL_Minimax_Choice(game_state, 1);
-		// std::cout << "The best move for " << game_state.next_turn << " is " << best_move << "\n";
+		// Move best_move = DL_Minimax_Choice(game_state, 1);
+		// std::cout << "The best move for " << game_state.next_turn << " is " << Move_to_UCI(best_move) << "\n";
 
 		// Update the game state with the new move
-		std::cout << "Player " << game_state.next_turn << " choses move " << new_move << "\n";
+		std::cout << "Player " << game_state.next_turn << " choses move " << Move_to_UCI(new_move) << "\n";
 		game_state = Simulate_Move(game_state, new_move);
 		game_state.Print();
 
@@ -169,20 +270,170 @@ int main()
 
 
 
-	// std::vector<std::string> a2_moves = Generate_Piece_Moves(from_fen, Convert_to_Index("b5"), false);
+	// std::vector<Move> a2_moves = Generate_Piece_Moves(from_fen, Convert_to_Index("b5"), false);
 	// for (int i = 0; i < a2_moves.size(); i++)
 	// {
-	// 	std::cout << a2_moves[i] << "\n";
+	// 	std::cout << Move_to_UCI(a2_moves[i]) << "\n";
 	// }
 
 	// bool attack = Square_Under_Attack(from_fen, Convert_to_Index("d2"), 'w');
 	// std::cout << "d2 under attack by black? " << attack << std::endl;
 
-	// Gamestate n_st = Simulate_Move(from_fen, "e2e4");
+	// Gamestate n_st = Simulate_Move(from_fen, Parse_Move(from_fen, "e2e4"));
 	// n_st.Print();
 
-	// Gamestate n_stt = Simulate_Move(n_st, "e4e2");
+	// Gamestate n_stt = Simulate_Move(n_st, Parse_Move(n_st, "e4e2"));
 	// n_stt.Print();
 
 	return 0;
-}
\ No newline at end of file
+}
+
+void Compare_Search_Algorithms(const std::vector<std::string>& fens, const int depth_limit)
+{
+	uint64_t total_minimax = 0;
+	uint64_t total_alpha_beta = 0;
+
+	// Null-move pruning and reductions can miss the best move on purpose, so only plain
+	// alpha-beta is expected to match minimax exactly
+	Search_Options saved_options = SEARCH_OPTIONS;
+	SEARCH_OPTIONS.null_move_pruning = false;
+	SEARCH_OPTIONS.late_move_reductions = false;
+
+	for (int i = 0; i < fens.size(); i++)
+	{
+		Gamestate g(fens[i]);
+		std::cout << fens[i] << "\n";
+
+		// Full-width minimax
+		int minimax_score = 0;
+		NODE_COUNT = 0;
+		Move minimax_move = Full_Minimax_Choice(g, depth_limit, minimax_score);
+		uint64_t minimax_nodes = NODE_COUNT;
+
+		// Alpha-beta, starting from an empty table and move ordering so nothing carries over
+		// between positions
+		TRANSPOSITION_TABLE.Clear();
+		MOVE_ORDERER.Clear();
+		NODE_COUNT = 0;
+		Move alpha_beta_move = DL_Minimax_Choice(g, depth_limit);
+		uint64_t alpha_beta_nodes = NODE_COUNT;
+
+		// Move ordering can make alpha-beta pick a different move out of several equally good
+		// ones, so check the minimax value of its move rather than the move itself
+		Gamestate after(g);
+		Undo_Record undo;
+		Make_Move(after, alpha_beta_move, undo);
+		int alpha_beta_score = -Full_Minimax(after, depth_limit, 1);
+
+		std::cout << "\tMinimax:    " << Move_to_UCI(minimax_move) << " (score " << minimax_score << "), " << minimax_nodes << " nodes\n";
+		std::cout << "\tAlpha-beta: " << Move_to_UCI(alpha_beta_move) << " (score " << alpha_beta_score << "), " << alpha_beta_nodes << " nodes ("
+				  << (100 * alpha_beta_nodes / minimax_nodes) << "% of minimax)"
+				  << (alpha_beta_score == minimax_score ? "" : "  ** DIFFERENT SCORE **") << "\n\n";
+
+		total_minimax += minimax_nodes;
+		total_alpha_beta += alpha_beta_nodes;
+	}
+
+	std::cout << "Total nodes at depth limit " << depth_limit << ": minimax " << total_minimax
+			  << ", alpha-beta " << total_alpha_beta << " (" << (100 * total_alpha_beta / total_minimax) << "%)\n";
+
+	SEARCH_OPTIONS = saved_options;
+}
+
+void Run_Bench(const std::vector<std::string>& fens, const int64_t movetime)
+{
+	std::vector<int> depths;
+	std::vector<uint64_t> node_counts;
+
+	for (int i = 0; i < fens.size(); i++)
+	{
+		Gamestate g(fens[i]);
+
+		// Start every position from scratch so the results do not depend on the order
+		TRANSPOSITION_TABLE.Clear();
+		MOVE_ORDERER.Clear();
+		NODE_COUNT = 0;
+
+		Search_Limits limits;
+		limits.movetime = movetime;
+		ID_DL_Minimax(g, limits);
+
+		depths.push_back(LAST_COMPLETED_DEPTH);
+		node_counts.push_back(NODE_COUNT);
+	}
+
+	std::cout << "\nNull-move pruning " << (SEARCH_OPTIONS.null_move_pruning ? "on" : "off")
+			  << ", late move reductions " << (SEARCH_OPTIONS.late_move_reductions ? "on" : "off")
+			  << ", " << movetime << " ms per position\n";
+	for (int i = 0; i < fens.size(); i++)
+	{
+		std::cout << "\tDepth " << depths[i] << ", " << node_counts[i] << " nodes - " << fens[i] << "\n";
+	}
+}
+
+void Run_SMP_Bench(const std::vector<std::string>& fens, const int depth)
+{
+	const std::vector<int> thread_counts = {1, 2, 4, 8, 16};
+	int saved_threads = SEARCH_OPTIONS.threads;
+
+	// Milliseconds taken for each position (row) with each thread count (column)
+	std::vector<std::vector<int64_t>> times(fens.size(), std::vector<int64_t>(thread_counts.size(), 0));
+
+	for (int i = 0; i < fens.size(); i++)
+	{
+		Gamestate g(fens[i]);
+		for (int t = 0; t < thread_counts.size(); t++)
+		{
+			// Start every run from scratch, so no run gets a head start from the table
+			TRANSPOSITION_TABLE.Clear();
+			MOVE_ORDERER.Clear();
+			NODE_COUNT = 0;
+			SEARCH_OPTIONS.threads = thread_counts[t];
+
+			Search_Limits limits;
+			limits.depth = depth;
+
+			// Keep the search's own output out of the table
+			auto start = std::chrono::steady_clock::now();
+			std::cout.setstate(std::ios::failbit);
+			ID_DL_Minimax(g, limits);
+			std::cout.clear();
+			auto end = std::chrono::steady_clock::now();
+
+			times[i][t] = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+			std::cout << "Position " << i + 1 << ", " << thread_counts[t] << " threads: " << times[i][t] << " ms, " << NODE_COUNT << " nodes\n";
+		}
+	}
+
+	// Speedup is the one-thread time divided by the time with more threads
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "\nTime to depth " << depth << " in ms (speedup over 1 thread), "
+			  << std::thread::hardware_concurrency() << " hardware threads\n";
+	std::cout << "Threads:";
+	for (int t = 0; t < thread_counts.size(); t++)
+	{
+		std::cout << "\t" << thread_counts[t] << "\t";
+	}
+	std::cout << "\n";
+
+	std::vector<int64_t> totals(thread_counts.size(), 0);
+	for (int i = 0; i < fens.size(); i++)
+	{
+		std::cout << "Pos " << i + 1 << ":";
+		for (int t = 0; t < thread_counts.size(); t++)
+		{
+			totals[t] += times[i][t];
+			std::cout << "\t" << times[i][t] << " (" << (times[i][t] > 0 ? double(times[i][0]) / times[i][t] : 0.0) << ")";
+		}
+		std::cout << "\n";
+	}
+
+	std::cout << "Total:";
+	for (int t = 0; t < thread_counts.size(); t++)
+	{
+		std::cout << "\t" << totals[t] << " (" << (totals[t] > 0 ? double(totals[0]) / totals[t] : 0.0) << ")";
+	}
+	std::cout << "\n";
+
+	SEARCH_OPTIONS.threads = saved_threads;
+}
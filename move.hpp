@@ -0,0 +1,172 @@
+#ifndef MOVE_HPP
+#define MOVE_HPP
+
+#include "bitboard.hpp"
+
+#include <string>
+
+
+// A move is packed into 16 bits:
+//   bits 0-5   = source square index (0-63)
+//   bits 6-11  = destination square index (0-63)
+//   bits 12-15 = flags describing the kind of move (see below)
+typedef uint16_t Move;
+
+// An empty move (a1a1) that is never valid, used as a "no move" marker
+const Move NULL_MOVE = 0;
+
+// Move flags. Bit 2 (value 4) is set for every capture, and bit 3 (value 8) for every
+// promotion, in which case the low two bits give the promotion piece (knight-queen)
+const int QUIET = 0;
+const int DOUBLE_PAWN_PUSH = 1;
+const int KING_CASTLE = 2;
+const int QUEEN_CASTLE = 3;
+const int CAPTURE = 4;
+const int EP_CAPTURE = 5;
+const int PROMOTION = 8;
+const int PROMOTION_CAPTURE = 12;
+
+// Most legal moves any chess position can have is 218, so a list of this many never overflows
+const int MAX_MOVES = 256;
+
+
+// A list of moves with a fixed capacity, stored inside the object itself so that building one
+// never allocates memory. Each move also has room for the ordering score the search gives it
+class Move_List
+{
+public:
+	Move moves[MAX_MOVES];
+	int scores[MAX_MOVES];
+	int count;
+
+	Move_List()
+	{
+		count = 0;
+	}
+
+	void push_back(const Move m)
+	{
+		moves[count] = m;
+		count++;
+	}
+
+	int size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	void clear()
+	{
+		count = 0;
+	}
+
+	Move& operator[](const int i)
+	{
+		return moves[i];
+	}
+
+	Move operator[](const int i) const
+	{
+		return moves[i];
+	}
+
+	// Check if the given move is in the list
+	bool Contains(const Move m) const
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (moves[i] == m)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+
+//////// Function Declarations ////////
+
+// Pack the given squares and flags into a move
+inline Move Create_Move(const int from, const int to, const int flags);
+
+// Unpack the source square, destination square, or flags of a move
+inline int Move_From(const Move m);
+inline int Move_To(const Move m);
+inline int Move_Flags(const Move m);
+
+// Check if a move captures a piece (including en passant)
+inline bool Is_Capture(const Move m);
+
+// Check if a move promotes a pawn
+inline bool Is_Promotion(const Move m);
+
+// Get the piece type (KNIGHT-QUEEN) a promotion move promotes to
+inline int Promotion_Type(const Move m);
+
+// Convert a move into UCI format ex) "e2e4" or "e7e8q"
+std::string Move_to_UCI(const Move m);
+
+
+//////// Function Implementations ////////
+
+inline Move Create_Move(const int from, const int to, const int flags)
+{
+	return Move(from | (to << 6) | (flags << 12));
+}
+
+inline int Move_From(const Move m)
+{
+	return m & 0x3F;
+}
+
+inline int Move_To(const Move m)
+{
+	return (m >> 6) & 0x3F;
+}
+
+inline int Move_Flags(const Move m)
+{
+	return m >> 12;
+}
+
+inline bool Is_Capture(const Move m)
+{
+	return (Move_Flags(m) & CAPTURE) != 0;
+}
+
+inline bool Is_Promotion(const Move m)
+{
+	return (Move_Flags(m) & PROMOTION) != 0;
+}
+
+inline int Promotion_Type(const Move m)
+{
+	return KNIGHT + (Move_Flags(m) & 3);
+}
+
+std::string Move_to_UCI(const Move m)
+{
+	std::string uci = "";
+
+	// Source and destination squares as file letter + rank digit
+	uci += char('a' + Move_From(m) % 8);
+	uci += char('1' + Move_From(m) / 8);
+	uci += char('a' + Move_To(m) % 8);
+	uci += char('1' + Move_To(m) / 8);
+
+	// Promotions add the lowercase piece letter
+	if (Is_Promotion(m))
+	{
+		uci += PIECE_CHARS[BLACK][Promotion_Type(m)];
+	}
+
+	return uci;
+}
+
+#endif
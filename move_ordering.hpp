@@ -0,0 +1,373 @@
+#ifndef MOVE_ORDERING_HPP
+#define MOVE_ORDERING_HPP
+
+#include "gamestate.hpp"
+#include "game_logic.hpp"
+#include "move.hpp"
+
+#include <iostream> // cout
+#include <cstdint> // uint64_t
+#include <utility> // std::swap
+
+
+// Deepest ply the search keeps per-ply information for
+const int MAX_PLY = 128;
+
+// Ordering scores for each kind of move. Every category is kept in its own range so that,
+// for example, any capture is always tried before any killer move
+const int HASH_MOVE_SCORE = 1000000;		// best move stored in the transposition table
+const int CAPTURE_SCORE = 500000;			// plus MVV-LVA bonus, also used for queen promotions
+const int FIRST_KILLER_SCORE = 400000;
+const int SECOND_KILLER_SCORE = 399000;
+const int HISTORY_MAX = 300000;				// history scores are kept below this
+
+// Stages of Move_Picker, in the order they are gone through. In check, the captures, killers, and
+// quiet moves are replaced by one stage with every move that gets out of check
+const int STAGE_HASH_MOVE = 0;
+const int STAGE_GENERATE_CAPTURES = 1;
+const int STAGE_CAPTURES = 2;
+const int STAGE_FIRST_KILLER = 3;
+const int STAGE_SECOND_KILLER = 4;
+const int STAGE_GENERATE_QUIETS = 5;
+const int STAGE_QUIETS = 6;
+const int STAGE_GENERATE_EVASIONS = 7;
+const int STAGE_EVASIONS = 8;
+const int STAGE_DONE = 9;
+
+
+// Scores moves so that the ones most likely to cause a beta cutoff are searched first:
+//   1. the hash move from the transposition table
+//   2. captures, most valuable victim first, then least valuable attacker first (MVV-LVA)
+//   3. killer moves - quiet moves that caused a cutoff at the same ply elsewhere in the tree
+//   4. other quiet moves, by how often they have caused cutoffs before (history heuristic)
+class Move_Orderer
+{
+public:
+	Move killers[MAX_PLY][2];			// two most recent quiet cutoff moves at each ply
+	int history[2][64][64];				// quiet cutoff credit, indexed [color][from][to]
+
+	// Cutoff statistics since the last Clear_Stats(), per ply
+	uint64_t cutoffs[MAX_PLY];				// beta cutoffs
+	uint64_t first_move_cutoffs[MAX_PLY];	// beta cutoffs caused by the first move searched
+
+	Move_Orderer()
+	{
+		Clear();
+	}
+
+	// Forget everything learned so far (for a new game)
+	void Clear()
+	{
+		Clear_Killers();
+		for (int color = 0; color < 2; color++)
+		{
+			for (int from = 0; from < 64; from++)
+			{
+				for (int to = 0; to < 64; to++)
+				{
+					history[color][from][to] = 0;
+				}
+			}
+		}
+		Clear_Stats();
+	}
+
+	// Forget the killer moves, which only make sense within one search
+	void Clear_Killers()
+	{
+		for (int ply = 0; ply < MAX_PLY; ply++)
+		{
+			killers[ply][0] = NULL_MOVE;
+			killers[ply][1] = NULL_MOVE;
+		}
+	}
+
+	// Reset the cutoff statistics
+	void Clear_Stats()
+	{
+		for (int ply = 0; ply < MAX_PLY; ply++)
+		{
+			cutoffs[ply] = 0;
+			first_move_cutoffs[ply] = 0;
+		}
+	}
+
+	// Fill in the ordering score of each move in the list (higher is searched first)
+	void Score_Moves(const Gamestate& g, Move_List& moves, const Move hash_move, const int ply)
+	{
+		int color = (g.next_turn == 'w' ? WHITE : BLACK);
+		int* scores = moves.scores;
+
+		for (int i = 0; i < moves.size(); i++)
+		{
+			Move m = moves[i];
+
+			if (m == hash_move)
+			{
+				scores[i] = HASH_MOVE_SCORE;
+			}
+			else if (Is_Capture(m) || (Is_Promotion(m) && Promotion_Type(m) == QUEEN))
+			{
+				// Piece type indices increase with value (pawn < knight/bishop < rook < queen), so
+				// they can be used directly. A queen promotion counts as winning a queen
+				int victim = (Move_Flags(m) == EP_CAPTURE ? PAWN : Piece_Type(g.board[Move_To(m)]));
+				if (victim == NO_PIECE_TYPE)
+				{
+					victim = PAWN;
+				}
+				if (Is_Promotion(m) && Promotion_Type(m) == QUEEN)
+				{
+					victim += QUEEN;
+				}
+				int attacker = Piece_Type(g.board[Move_From(m)]);
+
+				scores[i] = CAPTURE_SCORE + 10 * victim - attacker;
+			}
+			else if (m == killers[ply][0])
+			{
+				scores[i] = FIRST_KILLER_SCORE;
+			}
+			else if (m == killers[ply][1])
+			{
+				scores[i] = SECOND_KILLER_SCORE;
+			}
+			else
+			{
+				scores[i] = history[color][Move_From(m)][Move_To(m)];
+			}
+		}
+	}
+
+	// Swap the highest scoring move at or after index "start" into index "start". Picking moves
+	// one at a time avoids sorting the rest of the list when the first move causes a cutoff
+	void Pick_Move(Move_List& moves, const int start)
+	{
+		int* scores = moves.scores;
+		int best = start;
+		for (int i = start + 1; i < moves.size(); i++)
+		{
+			if (scores[i] > scores[best])
+			{
+				best = i;
+			}
+		}
+
+		std::swap(moves[start], moves[best]);
+		std::swap(scores[start], scores[best]);
+	}
+
+	// Record that "m" caused a beta cutoff at the given ply after "move_index" other moves were
+	// searched, and credit it if it was a quiet move
+	void Update_Cutoff(const Gamestate& g, const Move m, const int depth, const int ply, const int move_index)
+	{
+		cutoffs[ply]++;
+		if (move_index == 0)
+		{
+			first_move_cutoffs[ply]++;
+		}
+
+		// Captures and promotions are already ordered well without any extra credit
+		if (Is_Capture(m) || Is_Promotion(m))
+		{
+			return;
+		}
+
+		// Keep the two most recent different killers at this ply
+		if (killers[ply][0] != m)
+		{
+			killers[ply][1] = killers[ply][0];
+			killers[ply][0] = m;
+		}
+
+		// Cutoffs close to the root are worth more, since they prune larger subtrees
+		int color = (g.next_turn == 'w' ? WHITE : BLACK);
+		history[color][Move_From(m)][Move_To(m)] += depth * depth;
+
+		// Keep history below the killer scores by halving everything when it gets too large
+		if (history[color][Move_From(m)][Move_To(m)] >= HISTORY_MAX)
+		{
+			Age_History();
+		}
+	}
+
+	// Halve every history score so newer cutoffs count for more than old ones
+	void Age_History()
+	{
+		for (int color = 0; color < 2; color++)
+		{
+			for (int from = 0; from < 64; from++)
+			{
+				for (int to = 0; to < 64; to++)
+				{
+					history[color][from][to] /= 2;
+				}
+			}
+		}
+	}
+
+	// Output the percentage of cutoffs caused by the first move searched at each ply
+	void Print_Stats()
+	{
+		std::cout << "\tFirst-move cutoffs:";
+		for (int ply = 0; ply < MAX_PLY; ply++)
+		{
+			if (cutoffs[ply] != 0)
+			{
+				std::cout << " ply " << ply << ": " << (100 * first_move_cutoffs[ply] / cutoffs[ply]) << "% of " << cutoffs[ply] << ";";
+			}
+		}
+		std::cout << "\n";
+	}
+};
+
+
+// Hands out the moves of one node a few at a time, in the order Move_Orderer would sort them, but
+// only generating each group of moves once the ones before it have all been tried:
+//   1. the hash move, checked for legality without generating anything else
+//   2. captures and promotions, by MVV-LVA
+//   3. the two killer moves, again only checked for legality
+//   4. the remaining quiet moves, by history
+// Most nodes that cut off do so on the hash move or a capture, and never generate or score their
+// quiet moves at all. Moves already handed out in an earlier stage are skipped in the later ones
+class Move_Picker
+{
+public:
+	const Gamestate& g;
+	Move_Orderer& orderer;
+	int ply;
+	bool in_check;
+	int stage;
+	Move hash_move;
+	Move killers[2];				// killers at this ply when the picker was created
+	Move_List& moves;				// moves of the current stage, with their ordering scores
+	int next;						// index in "moves" of the next move to hand out
+
+	// "moves" is where each stage's moves are generated, and has to stay untouched until the
+	// picker is done with it
+	Move_Picker(const Gamestate& g, Move_Orderer& orderer, Move_List& moves, const Move hash_move, const int ply, const bool in_check)
+		: g(g), orderer(orderer), moves(moves)
+	{
+		this->ply = ply;
+		this->in_check = in_check;
+		this->hash_move = hash_move;
+		stage = STAGE_HASH_MOVE;
+		killers[0] = orderer.killers[ply][0];
+		killers[1] = orderer.killers[ply][1];
+		next = 0;
+	}
+
+	// Get the next move to search, or NULL_MOVE once every legal move has been handed out
+	Move Next_Move()
+	{
+		while (true)
+		{
+			switch (stage)
+			{
+				case STAGE_HASH_MOVE:
+				{
+					stage = (in_check ? STAGE_GENERATE_EVASIONS : STAGE_GENERATE_CAPTURES);
+
+					// The stored move may come from a different position with the same key
+					if (Is_Legal_Move(g, hash_move))
+					{
+						return hash_move;
+					}
+					break;
+				}
+				case STAGE_GENERATE_CAPTURES:
+				{
+					Generate_Stage(GEN_CAPTURES);
+					stage = STAGE_CAPTURES;
+					break;
+				}
+				case STAGE_CAPTURES:
+				{
+					Move m = Pick_Next();
+					if (m != NULL_MOVE)
+					{
+						return m;
+					}
+					stage = STAGE_FIRST_KILLER;
+					break;
+				}
+				case STAGE_FIRST_KILLER:
+				case STAGE_SECOND_KILLER:
+				{
+					// Killers are always quiet, so they cannot have been handed out as captures.
+					// They were found in other positions, so they may not be legal in this one
+					Move killer = killers[stage - STAGE_FIRST_KILLER];
+					stage++;
+					if (killer != hash_move && Is_Legal_Move(g, killer))
+					{
+						return killer;
+					}
+					break;
+				}
+				case STAGE_GENERATE_QUIETS:
+				{
+					Generate_Stage(GEN_QUIETS);
+					stage = STAGE_QUIETS;
+					break;
+				}
+				case STAGE_QUIETS:
+				{
+					Move m = Pick_Next();
+					if (m != NULL_MOVE)
+					{
+						return m;
+					}
+					stage = STAGE_DONE;
+					break;
+				}
+				case STAGE_GENERATE_EVASIONS:
+				{
+					Generate_Stage(GEN_ALL);
+					stage = STAGE_EVASIONS;
+					break;
+				}
+				case STAGE_EVASIONS:
+				{
+					Move m = Pick_Next();
+					if (m != NULL_MOVE)
+					{
+						return m;
+					}
+					stage = STAGE_DONE;
+					break;
+				}
+				default:
+					return NULL_MOVE;
+			}
+		}
+	}
+
+	// Replace the current stage's moves with newly generated ones of the given kind, and score them
+	void Generate_Stage(const int gen_type)
+	{
+		moves.clear();
+		next = 0;
+		Generate_Legal_Moves(g, (g.next_turn == 'w' ? WHITE : BLACK), moves, gen_type);
+		orderer.Score_Moves(g, moves, NULL_MOVE, ply);
+	}
+
+	// Get the best scoring move of the current stage not handed out yet, or NULL_MOVE if there
+	// are none left
+	Move Pick_Next()
+	{
+		while (next < moves.size())
+		{
+			orderer.Pick_Move(moves, next);
+			Move m = moves[next];
+			next++;
+
+			if (m != hash_move && (stage != STAGE_QUIETS || (m != killers[0] && m != killers[1])))
+			{
+				return m;
+			}
+		}
+
+		return NULL_MOVE;
+	}
+};
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include "gamestate.hpp"
+#include "game_logic.hpp"
+
+#include <vector>
+#include <string>
+#include <iostream> // cout
+#include <chrono> // steady_clock
+#include <cstdint> // uint64_t
+
+
+// A test position with its known perft node counts. expected[d - 1] is the count at depth d
+class Perft_Position
+{
+public:
+	std::string name;
+	std::string fen;
+	std::vector<uint64_t> expected;
+};
+
+// Standard perft positions and their published node counts
+const std::vector<Perft_Position> PERFT_SUITE =
+{
+	{"Start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		{20, 400, 8902, 197281, 4865609, 119060324}},
+	{"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		{48, 2039, 97862, 4085603, 193690690}},
+	{"Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+		{14, 191, 2812, 43238, 674624, 11030083}},
+	{"Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+		{6, 264, 9467, 422333, 15833292}},
+	{"Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+		{44, 1486, 62379, 2103487, 89941194}},
+	{"Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		{46, 2079, 89890, 3894594, 164075551}}
+};
+
+
+//////// Function Declarations ////////
+
+// Count every leaf node of the legal move tree down to the given depth. Moves are made and
+// unmade on "g" in place, so it is back in its original state on return
+uint64_t Perft(Gamestate& g, const int depth);
+
+// Run perft from the given position, printing the count below each root move followed by the
+// total, the time taken, and the nodes per second. Returns the total
+uint64_t Divide(const std::string fen, const int depth);
+
+// Run perft on every PERFT_SUITE position up to the given depth (or as deep as it has known
+// counts), comparing against the known counts. Returns true if every count matched
+bool Run_Perft_Suite(const int max_depth);
+
+
+//////// Function Implementations ////////
+
+uint64_t Perft(Gamestate& g, const int depth)
+{
+	if (depth == 0)
+	{
+		return 1;
+	}
+
+	Move_List valid_moves = Generate_Player_Moves(g, g.next_turn);
+
+	// Every valid move leads to exactly one leaf, so there is no need to make them
+	if (depth == 1)
+	{
+		return valid_moves.size();
+	}
+
+	uint64_t nodes = 0;
+	Undo_Record undo;
+	for (int i = 0; i < valid_moves.size(); i++)
+	{
+		Make_Move(g, valid_moves[i], undo);
+		nodes += Perft(g, depth - 1);
+		Unmake_Move(g, valid_moves[i], undo);
+	}
+
+	return nodes;
+}
+
+uint64_t Divide(const std::string fen, const int depth)
+{
+	Gamestate g(fen);
+	Move_List valid_moves = Generate_Player_Moves(g, g.next_turn);
+
+	auto start = std::chrono::steady_clock::now();
+
+	// Count the leaves below each root move separately
+	uint64_t total = 0;
+	Undo_Record undo;
+	for (int i = 0; i < valid_moves.size(); i++)
+	{
+		Make_Move(g, valid_moves[i], undo);
+		uint64_t nodes = (depth > 1 ? Perft(g, depth - 1) : 1);
+		Unmake_Move(g, valid_moves[i], undo);
+
+		std::cout << Move_to_UCI(valid_moves[i]) << ": " << nodes << "\n";
+		total += nodes;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+	std::cout << "\nMoves: " << valid_moves.size() << "\n";
+	std::cout << "Nodes: " << total << "\n";
+	std::cout << "Time: " << ms << " ms\n";
+	std::cout << "NPS: " << (ms > 0 ? total * 1000 / ms : total * 1000) << "\n";
+
+	return total;
+}
+
+bool Run_Perft_Suite(const int max_depth)
+{
+	bool all_passed = true;
+	uint64_t total_nodes = 0;
+	uint64_t total_ms = 0;
+
+	for (int i = 0; i < PERFT_SUITE.size(); i++)
+	{
+		const Perft_Position& p = PERFT_SUITE[i];
+		std::cout << p.name << " - " << p.fen << "\n";
+
+		Gamestate g(p.fen);
+		for (int depth = 1; depth <= max_depth && depth <= p.expected.size(); depth++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			uint64_t nodes = Perft(g, depth);
+			auto end = std::chrono::steady_clock::now();
+			uint64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+			bool passed = (nodes == p.expected[depth - 1]);
+			all_passed = all_passed && passed;
+			total_nodes += nodes;
+			total_ms += ms;
+
+			std::cout << "\tDepth " << depth << ": " << nodes
+					  << (passed ? " ok" : " FAILED (expected " + std::to_string(p.expected[depth - 1]) + ")")
+					  << ", " << ms << " ms, " << (ms > 0 ? nodes * 1000 / ms : nodes * 1000) << " nps\n";
+		}
+	}
+
+	std::cout << "\n" << (all_passed ? "All counts match" : "SOME COUNTS DO NOT MATCH")
+			  << " - " << total_nodes << " nodes in " << total_ms << " ms ("
+			  << (total_ms > 0 ? total_nodes * 1000 / total_ms : total_nodes * 1000) << " nps)\n";
+
+	return all_passed;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef PIECE_SQUARE_HPP
+#define PIECE_SQUARE_HPP
+
+#include "bitboard.hpp"
+
+
+// Every piece is worth its material value plus a bonus (or penalty) for the square it stands on.
+// There are two sets of values: one for the middlegame, and one for the endgame, when for example
+// the king should come out to the center instead of hiding behind its pawns. Gamestate keeps the
+// sum of both over every piece up to date as pieces are added and removed, and the evaluation
+// blends the two by how much material is left (the game "phase")
+
+// Material values in centipawns for each piece type, indexed by PAWN-KING
+const int MG_PIECE_VALUES[6] = {82, 337, 365, 477, 1025, 0};
+const int EG_PIECE_VALUES[6] = {94, 281, 297, 512, 936, 0};
+
+// How much each piece type counts towards the phase. The starting position has MAX_PHASE, and
+// a board with only kings and pawns has 0
+const int PHASE_WEIGHTS[6] = {0, 1, 1, 2, 4, 0};
+const int MAX_PHASE = 24;
+
+// Square bonuses for white pieces, written the way the board looks from white's side (a8 is the
+// top left, h1 the bottom right). Black uses the same tables flipped top to bottom
+const int MG_PAWN_TABLE[64] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 10,  10,  20,  30,  30,  20,  10,  10,
+	  5,   5,  10,  25,  25,  10,   5,   5,
+	  0,   0,   0,  20,  20,   0,   0,   0,
+	  5,  -5, -10,   0,   0, -10,  -5,   5,
+	  5,  10,  10, -20, -20,  10,  10,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int EG_PAWN_TABLE[64] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	 90,  90,  90,  90,  90,  90,  90,  90,
+	 50,  50,  50,  50,  50,  50,  50,  50,
+	 30,  30,  30,  30,  30,  30,  30,  30,
+	 15,  15,  15,  15,  15,  15,  15,  15,
+	  5,   5,   5,   5,   5,   5,   5,   5,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int MG_KNIGHT_TABLE[64] =
+{
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   5,  15,  20,  20,  15,   5, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   5,  10,  15,  15,  10,   5, -30,
+	-40, -20,   0,   5,   5,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const int EG_KNIGHT_TABLE[64] =
+{
+	-50, -40, -30, -30, -30, -30, -40, -50,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   0,  15,  20,  20,  15,   0, -30,
+	-30,   0,  10,  15,  15,  10,   0, -30,
+	-40, -20,   0,   0,   0,   0, -20, -40,
+	-50, -40, -30, -30, -30, -30, -40, -50
+};
+
+const int MG_BISHOP_TABLE[64] =
+{
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   5,   5,  10,  10,   5,   5, -10,
+	-10,   0,  10,  10,  10,  10,   0, -10,
+	-10,  10,  10,  10,  10,  10,  10, -10,
+	-10,   5,   0,   0,   0,   0,   5, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const int EG_BISHOP_TABLE[64] =
+{
+	-20, -10, -10, -10, -10, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   0,  10,  15,  15,  10,   0, -10,
+	-10,   0,  10,  15,  15,  10,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-20, -10, -10, -10, -10, -10, -10, -20
+};
+
+const int MG_ROOK_TABLE[64] =
+{
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  5,  10,  10,  10,  10,  10,  10,   5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	 -5,   0,   0,   0,   0,   0,   0,  -5,
+	  0,   0,   0,   5,   5,   0,   0,   0
+};
+
+const int EG_ROOK_TABLE[64] =
+{
+	  5,   5,   5,   5,   5,   5,   5,   5,
+	 10,  10,  10,  10,  10,  10,  10,  10,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0,
+	  0,   0,   0,   0,   0,   0,   0,   0
+};
+
+const int MG_QUEEN_TABLE[64] =
+{
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,   5,   5,   5,   0, -10,
+	 -5,   0,   5,   5,   5,   5,   0,  -5,
+	  0,   0,   5,   5,   5,   5,   0,  -5,
+	-10,   5,   5,   5,   5,   5,   0, -10,
+	-10,   0,   5,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+const int EG_QUEEN_TABLE[64] =
+{
+	-20, -10, -10,  -5,  -5, -10, -10, -20,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	 -5,   0,  10,  15,  15,  10,   0,  -5,
+	 -5,   0,  10,  15,  15,  10,   0,  -5,
+	-10,   0,   5,  10,  10,   5,   0, -10,
+	-10,   0,   0,   0,   0,   0,   0, -10,
+	-20, -10, -10,  -5,  -5, -10, -10, -20
+};
+
+const int MG_KING_TABLE[64] =
+{
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-30, -40, -40, -50, -50, -40, -40, -30,
+	-20, -30, -30, -40, -40, -30, -30, -20,
+	-10, -20, -20, -20, -20, -20, -20, -10,
+	 20,  20,   0,   0,   0,   0,  20,  20,
+	 20,  30,  10,   0,   0,  10,  30,  20
+};
+
+const int EG_KING_TABLE[64] =
+{
+	-50, -40, -30, -20, -20, -30, -40, -50,
+	-30, -20, -10,   0,   0, -10, -20, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  30,  40,  40,  30, -10, -30,
+	-30, -10,  20,  30,  30,  20, -10, -30,
+	-30, -30,   0,   0,   0,   0, -30, -30,
+	-50, -30, -30, -30, -30, -30, -30, -50
+};
+
+// The tables above for each piece type, indexed by PAWN-KING
+const int* const MG_TABLES[6] = {MG_PAWN_TABLE, MG_KNIGHT_TABLE, MG_BISHOP_TABLE, MG_ROOK_TABLE, MG_QUEEN_TABLE, MG_KING_TABLE};
+const int* const EG_TABLES[6] = {EG_PAWN_TABLE, EG_KNIGHT_TABLE, EG_BISHOP_TABLE, EG_ROOK_TABLE, EG_QUEEN_TABLE, EG_KING_TABLE};
+
+// Material plus square bonus of every piece on every square, from white's point of view (black
+// pieces are negative), indexed [color][type][square]
+int PSQT_MG[2][6][64];
+int PSQT_EG[2][6][64];
+
+
+//////// Function Declarations ////////
+
+// Fill in the combined material and square tables. Calls after the first do nothing
+void Init_Piece_Square_Tables();
+
+
+//////// Function Implementations ////////
+
+void Init_Piece_Square_Tables()
+{
+	static const bool initialized = []
+	{
+		for (int type = 0; type < 6; type++)
+		{
+			for (int sq = 0; sq < 64; sq++)
+			{
+				// The tables are written with rank 8 first, so flip the rank to get white's entry.
+				// Black's pieces see the board from the other side, which is the square itself
+				int white_entry = sq ^ 56;
+				int black_entry = sq;
+
+				PSQT_MG[WHITE][type][sq] = MG_PIECE_VALUES[type] + MG_TABLES[type][white_entry];
+				PSQT_EG[WHITE][type][sq] = EG_PIECE_VALUES[type] + EG_TABLES[type][white_entry];
+				PSQT_MG[BLACK][type][sq] = -(MG_PIECE_VALUES[type] + MG_TABLES[type][black_entry]);
+				PSQT_EG[BLACK][type][sq] = -(EG_PIECE_VALUES[type] + EG_TABLES[type][black_entry]);
+			}
+		}
+
+		return true;
+	}();
+	(void)initialized;
+}
+
+#endif
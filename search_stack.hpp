@@ -0,0 +1,72 @@
+#ifndef SEARCH_STACK_HPP
+#define SEARCH_STACK_HPP
+
+#include "game_logic.hpp"
+#include "move.hpp"
+#include "move_ordering.hpp"
+
+#include <string>
+
+
+// Everything the search keeps for one node while it is being searched. The search functions use
+// the entry for their own ply instead of local variables, so nothing is allocated (or even copied
+// onto the call stack) per node
+class Search_Ply
+{
+public:
+	Move_List moves;			// moves of the node, or of the current stage of its Move_Picker
+	Undo_Record undo;			// what the move being searched from this node overwrote
+	Move pv[MAX_PLY];			// best line found from this node, starting with its best move
+	int pv_length;
+};
+
+
+// One entry per ply from the root, set up once before the search starts. Killer moves, which are
+// also kept per ply, live in Move_Orderer. Each search thread needs a stack of its own
+class Search_Stack
+{
+public:
+	// One extra ply, so the deepest node can still look at its children's (empty) entry
+	Search_Ply plies[MAX_PLY + 1];
+
+	Search_Stack()
+	{
+		for (int ply = 0; ply <= MAX_PLY; ply++)
+		{
+			plies[ply].pv_length = 0;
+		}
+	}
+
+	// Start the line at the given ply over, before that node has searched anything
+	void Clear_PV(const int ply)
+	{
+		plies[ply].pv_length = 0;
+	}
+
+	// Make "m" followed by the best line found one ply deeper the best line at the given ply
+	void Update_PV(const int ply, const Move m)
+	{
+		Search_Ply& node = plies[ply];
+		const Search_Ply& child = plies[ply + 1];
+
+		node.pv[0] = m;
+		for (int i = 0; i < child.pv_length; i++)
+		{
+			node.pv[i + 1] = child.pv[i];
+		}
+		node.pv_length = child.pv_length + 1;
+	}
+
+	// Get the best line found from the root as UCI moves separated by spaces
+	std::string PV_String() const
+	{
+		std::string line = "";
+		for (int i = 0; i < plies[0].pv_length; i++)
+		{
+			line += (i > 0 ? " " : "") + Move_to_UCI(plies[0].pv[i]);
+		}
+		return line;
+	}
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "../uci.hpp"
+
+
+// Checks of the UCI front-end: commands are fed to a UCI_Engine one at a time, with everything
+// it prints captured, and the replies are checked. Returns 0 if every check passed
+
+
+// Carry out one command, wait for any search it started to send its "bestmove", and get
+// everything the engine printed meanwhile
+std::string Send_Command(UCI_Engine& engine, std::stringstream& output, const std::string command);
+
+// Get the depth of the last "info depth" line, or -1 if there is none
+int Last_Info_Depth(const std::string output);
+
+// Get the node count of the last "info" line, or 0 if there is none
+uint64_t Last_Info_Nodes(const std::string output);
+
+// Print the result of one check (to cerr, since cout is captured), and return "passed"
+bool Report(const std::string name, const bool passed, const std::string details);
+
+
+int main()
+{
+	// Capture the engine's output instead of printing it
+	std::stringstream output;
+	std::streambuf* console = std::cout.rdbuf(output.rdbuf());
+
+	bool all_passed = true;
+	{
+		UCI_Engine engine;
+
+		// "go depth n" stops after exactly n plies, down to a single one
+		for (int depth : {1, 3})
+		{
+			Send_Command(engine, output, "position startpos");
+			std::string reply = Send_Command(engine, output, "go depth " + std::to_string(depth));
+			int last_depth = Last_Info_Depth(reply);
+			bool passed = (last_depth == depth && reply.find("bestmove ") != std::string::npos);
+			all_passed &= Report("go depth " + std::to_string(depth), passed, "last info depth " + std::to_string(last_depth));
+		}
+
+		// A depth beyond what the search has room for is cut down to the deepest it can go. Bare
+		// kings keep every iteration short
+		Send_Command(engine, output, "position fen 8/8/8/4k3/8/8/8/4K3 w - - 0 1");
+		std::string deep_reply = Send_Command(engine, output, "go depth 300");
+		int deepest = Last_Info_Depth(deep_reply);
+		bool deep_passed = (deepest == MAX_PLY && deep_reply.find("bestmove ") != std::string::npos);
+		all_passed &= Report("go depth 300", deep_passed, "last info depth " + std::to_string(deepest));
+
+		// A FEN without move counters is completed with "0 1"
+		Gamestate expected("8/8/8/4k3/8/8/3QK3/8 w - - 0 1");
+		Undo_Record undo;
+		Make_Move(expected, Parse_Move(expected, "d2d3"), undo);
+		Send_Command(engine, output, "position fen 8/8/8/4k3/8/8/3QK3/8 w - - moves d2d3");
+		bool passed = (engine.position.hash_key == expected.hash_key && engine.position.fullmove_counter == 1);
+		all_passed &= Report("position fen without move counters", passed, "fullmove " + std::to_string(engine.position.fullmove_counter));
+
+		// A FEN with fewer than 4 fields is rejected, leaving the last position in place
+		Send_Command(engine, output, "position fen 8/8/8/4k3/8/8/3QK3/8 w");
+		passed = (engine.position.hash_key == expected.hash_key);
+		all_passed &= Report("position fen with missing fields", passed, "position " + std::string(passed ? "kept" : "changed"));
+
+		// A ponder search keeps going past its node limit until "ponderhit", and only then answers
+		Send_Command(engine, output, "position startpos moves e2e4");
+		engine.Handle_Command("go ponder nodes 1000");
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		std::string pondered;
+		{
+			std::lock_guard<std::mutex> lock(OUTPUT_MUTEX);
+			pondered = output.str();
+		}
+		std::string reply = Send_Command(engine, output, "ponderhit");
+		uint64_t nodes = Last_Info_Nodes(pondered);
+		passed = (nodes > 1000 && pondered.find("bestmove") == std::string::npos && reply.find("bestmove") != std::string::npos);
+		all_passed &= Report("go ponder nodes 1000", passed, std::to_string(nodes) + " nodes before ponderhit");
+	}
+
+	std::cout.rdbuf(console);
+	std::cout << (all_passed ? "All UCI checks passed\n" : "Some UCI checks FAILED\n");
+	return (all_passed ? 0 : 1);
+}
+
+std::string Send_Command(UCI_Engine& engine, std::stringstream& output, const std::string command)
+{
+	// A ponder search may still be printing, so clear the output the same way it writes
+	{
+		std::lock_guard<std::mutex> lock(OUTPUT_MUTEX);
+		output.str("");
+	}
+	engine.Handle_Command(command);
+	engine.Wait_For_Search();
+
+	// The worker has finished printing, so the output is safe to read
+	std::lock_guard<std::mutex> lock(OUTPUT_MUTEX);
+	return output.str();
+}
+
+int Last_Info_Depth(const std::string output)
+{
+	int depth = -1;
+	std::istringstream lines(output);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		std::istringstream tokens(line);
+		std::string info, field;
+		if (tokens >> info >> field && info == "info" && field == "depth")
+		{
+			tokens >> depth;
+		}
+	}
+	return depth;
+}
+
+uint64_t Last_Info_Nodes(const std::string output)
+{
+	uint64_t nodes = 0;
+	std::istringstream lines(output);
+	std::string line;
+	while (std::getline(lines, line))
+	{
+		// Find the number after "nodes" on each info line
+		std::istringstream tokens(line);
+		std::string info, token;
+		if (!(tokens >> info) || info != "info")
+		{
+			continue;
+		}
+		while (tokens >> token)
+		{
+			if (token == "nodes")
+			{
+				tokens >> nodes;
+				break;
+			}
+		}
+	}
+	return nodes;
+}
+
+bool Report(const std::string name, const bool passed, const std::string details)
+{
+	std::cerr << "\t" << name << ": " << details << (passed ? " ok" : " FAILED") << "\n";
+	return passed;
+}
@@ -0,0 +1,186 @@
+#ifndef TIME_MANAGER_HPP
+#define TIME_MANAGER_HPP
+
+#include <chrono> // steady_clock
+#include <cstdint> // int64_t
+#include <algorithm> // std::min, std::max
+#include <atomic>
+
+
+// Time kept back from every move for the delay between deciding on a move and the clock stopping
+const int64_t MOVE_OVERHEAD_MS = 30;
+
+// Number of moves assumed to be left in the game when the time control does not say
+const int DEFAULT_MOVES_TO_GO = 30;
+
+// How many nodes are searched between checks of the clock
+const uint64_t TIME_CHECK_INTERVAL = 1024;
+
+
+// What the search is allowed to use for one move. Any limit left at 0 (-1 for depth) is not used
+class Search_Limits
+{
+public:
+	int64_t wtime = 0;			// white's remaining clock time in milliseconds
+	int64_t btime = 0;			// black's remaining clock time in milliseconds
+	int64_t winc = 0;			// white's increment per move in milliseconds
+	int64_t binc = 0;			// black's increment per move in milliseconds
+	int movestogo = 0;			// moves until the next time control (0 = rest of the game)
+	int64_t movetime = 0;		// search exactly this many milliseconds
+	int depth = -1;				// deepest iteration to search (iteration 0 is already a 1-ply search)
+	uint64_t nodes = 0;			// stop after visiting this many positions
+	bool infinite = false;		// keep searching until told to stop, however deep that gets
+	bool ponder = false;		// searching on the opponent's time: no limit applies until Ponder_Hit()
+};
+
+
+// Decides how long to search for a move, and tells a running search when it has to stop.
+// Two budgets are worked out when the search starts:
+//   soft limit - a new iteration is only started if it is expected to finish before the hard limit,
+//                and never once the soft limit has passed
+//   hard limit - a running iteration is aborted
+// A ponder search ignores both until the opponent plays the expected move, and only then starts
+// the clock, so the time spent pondering is free
+class Time_Manager
+{
+public:
+	std::chrono::steady_clock::time_point search_start_time;	// when the search started
+	std::chrono::steady_clock::time_point start_time;			// when the clock started (later if pondering)
+	bool timed;					// false if the search has no time limit at all
+	bool fixed_time;			// true if the search was given an exact move time to use up
+	int64_t soft_limit_ms;
+	int64_t hard_limit_ms;
+	uint64_t node_limit;		// positions the search may visit, or 0 for no limit
+	bool pondering;				// the clock has not started yet. Only read and written by the main search thread
+	std::atomic<bool> ponder_hit_pending;	// set from any thread by Ponder_Hit(), until the search notices
+
+	Time_Manager()
+	{
+		timed = false;
+		fixed_time = false;
+		soft_limit_ms = 0;
+		hard_limit_ms = 0;
+		node_limit = 0;
+		pondering = false;
+		ponder_hit_pending = false;
+	}
+
+	// Start the clock for a search by the given player ('w' or 'b'), and work out its budgets. A
+	// ponder hit that came in before the search started still counts, so it is not cleared here
+	void Start(const Search_Limits& limits, const char player_color)
+	{
+		search_start_time = std::chrono::steady_clock::now();
+		start_time = search_start_time;
+		node_limit = limits.nodes;
+		pondering = limits.ponder;
+		Check_Ponder_Hit();
+
+		int64_t time_left = (player_color == 'w' ? limits.wtime : limits.btime);
+		int64_t increment = (player_color == 'w' ? limits.winc : limits.binc);
+		fixed_time = (limits.movetime > 0);
+
+		// A fixed move time is used all the way to the end
+		if (fixed_time)
+		{
+			timed = true;
+			hard_limit_ms = std::max<int64_t>(limits.movetime - MOVE_OVERHEAD_MS, 1);
+			soft_limit_ms = hard_limit_ms;
+			return;
+		}
+
+		if (time_left <= 0)
+		{
+			timed = false;
+			return;
+		}
+		timed = true;
+
+		// Never plan to use the overhead, and always leave at least a little time to search
+		int64_t usable = std::max<int64_t>(time_left - MOVE_OVERHEAD_MS, 1);
+
+		// Share the remaining time evenly between the moves left, plus most of the increment,
+		// which comes back after the move anyway
+		int moves_to_go = (limits.movestogo > 0 ? limits.movestogo : DEFAULT_MOVES_TO_GO);
+		soft_limit_ms = usable / moves_to_go + increment * 3 / 4;
+
+		// An iteration that runs long may go a few times over its share, but never so far that
+		// the rest of the game is left short. With one move to go, everything left is usable
+		int64_t max_hard = (moves_to_go == 1 ? usable : usable / 2);
+		hard_limit_ms = std::min<int64_t>(soft_limit_ms * 4, max_hard);
+		soft_limit_ms = std::min<int64_t>(soft_limit_ms, hard_limit_ms);
+	}
+
+	// Get the number of milliseconds on the clock, which starts at Start() or at the ponder hit
+	int64_t Elapsed_Ms() const
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time).count();
+	}
+
+	// Get the number of milliseconds since Start(), including any time spent pondering
+	int64_t Search_Ms() const
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - search_start_time).count();
+	}
+
+	// Tell a ponder search that the opponent played the expected move. Safe to call from any
+	// thread; the search starts the clock the next time it calls Check_Ponder_Hit()
+	void Ponder_Hit()
+	{
+		ponder_hit_pending = true;
+	}
+
+	// Called by the main search thread: if a ponder hit has come in, turn the ponder search into
+	// a normal timed search, keeping everything it has searched so far
+	void Check_Ponder_Hit()
+	{
+		if (pondering && ponder_hit_pending.exchange(false))
+		{
+			pondering = false;
+			start_time = std::chrono::steady_clock::now();
+		}
+	}
+
+	// Check if the running iteration has to be aborted
+	bool Out_Of_Time() const
+	{
+		return !pondering && timed && Elapsed_Ms() >= hard_limit_ms;
+	}
+
+	// Check if the search has visited as many positions as it was allowed. Like the time limits,
+	// the node limit only applies once a ponder search has had its ponder hit
+	bool Out_Of_Nodes(const uint64_t nodes) const
+	{
+		return !pondering && node_limit > 0 && nodes >= node_limit;
+	}
+
+	// Decide whether another iteration is worth starting, given how long the last two took. Each
+	// iteration usually takes a few times longer than the one before it, so if the next one would
+	// not finish before the hard limit it would only be aborted and wasted
+	bool Start_Next_Iteration(const int64_t last_iteration_ms, const int64_t previous_iteration_ms) const
+	{
+		if (!timed || pondering)
+		{
+			return true;
+		}
+
+		int64_t elapsed = Elapsed_Ms();
+		if (elapsed >= soft_limit_ms)
+		{
+			return false;
+		}
+
+		// Time left over from a fixed move time cannot be saved for later, so keep searching
+		if (fixed_time)
+		{
+			return true;
+		}
+
+		// Estimate the growth from the last two iterations, kept within a sensible range
+		int64_t growth = (previous_iteration_ms > 0 ? last_iteration_ms / previous_iteration_ms : 2);
+		growth = std::min<int64_t>(std::max<int64_t>(growth, 2), 8);
+
+		return elapsed + last_iteration_ms * growth < hard_limit_ms;
+	}
+};
+
+#endif
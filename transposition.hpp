@@ -0,0 +1,294 @@
+#ifndef TRANSPOSITION_HPP
+#define TRANSPOSITION_HPP
+
+#include "move.hpp"
+
+#include <vector>
+#include <atomic>
+#include <iostream> // cout
+#include <cstdint> // uint64_t
+#include <algorithm> // std::min, std::max
+
+
+// Default transposition table size in megabytes
+const int DEFAULT_TT_SIZE_MB = 16;
+
+// What a stored score means relative to the true value of the position
+const uint8_t EMPTY_BOUND = 0;		// the entry has never been written
+const uint8_t EXACT_BOUND = 1;		// score is the exact value
+const uint8_t LOWER_BOUND = 2;		// true value >= score (the search failed high)
+const uint8_t UPPER_BOUND = 3;		// true value <= score (the search failed low)
+
+// Entries per bucket. Four 16-byte entries fill one 64-byte cache line, so looking at a whole
+// bucket costs a single memory access
+const int TT_BUCKET_SIZE = 4;
+
+// Searches are numbered modulo this, so entries left over from earlier searches can be told apart
+const int TT_GENERATIONS = 64;
+
+// When choosing an entry to overwrite, each search an entry is out of date counts the same as
+// this many plies of depth
+const int TT_AGE_WEIGHT = 8;
+
+// Range of depths an entry can hold in its 8-bit field. Deeper results are stored as the deepest
+const int TT_MIN_DEPTH = -128;
+const int TT_MAX_DEPTH = 127;
+
+
+// The result of searching one position, as handed out by Probe()
+class TT_Entry
+{
+public:
+	uint64_t key;			// full Zobrist key, used to tell apart positions that share a bucket
+	int score;				// value found by the search
+	Move best_move;			// best move found, or NULL_MOVE if none
+	int8_t depth;			// depth the position was searched to
+	uint8_t bound;			// one of the *_BOUND values
+};
+
+// One stored entry, packed into two 64-bit words that are each read and written atomically.
+// "data" holds everything but the key:
+//   bits 0-15  = best move
+//   bits 16-23 = depth
+//   bits 24-25 = bound
+//   bits 26-31 = generation of the search that wrote it
+//   bits 32-63 = score
+// and "key_xor_data" holds the key XOR-ed with "data". Threads read and write the table without
+// locks, so a reader can see one word from one write and the other from another. The key worked
+// out from such a mix does not match, so a torn entry is never mistaken for a valid one
+class TT_Slot
+{
+public:
+	std::atomic<uint64_t> key_xor_data;
+	std::atomic<uint64_t> data;
+};
+
+// The entries a hash index can go in, aligned to a cache line
+class alignas(64) TT_Bucket
+{
+public:
+	TT_Slot slots[TT_BUCKET_SIZE];
+};
+
+// Usage statistics since the last Clear_Stats(). Each search thread counts its own, so the
+// counters never bounce between cores
+class TT_Stats
+{
+public:
+	uint64_t probes = 0;			// lookups made
+	uint64_t hits = 0;				// lookups that found the position
+	uint64_t stores = 0;			// results written
+	uint64_t collisions = 0;		// writes that overwrote a different position
+};
+
+thread_local TT_Stats TT_STATS;
+
+
+// Fixed-size hash table of search results, indexed by Zobrist key and shared by every search thread
+class Transposition_Table
+{
+public:
+	std::vector<TT_Bucket> buckets;
+	uint64_t index_mask;			// number of buckets - 1 (always a power of 2)
+	uint8_t generation;				// number of the current search, modulo TT_GENERATIONS
+
+	// Create a table using roughly the given number of megabytes
+	Transposition_Table(const int size_mb = DEFAULT_TT_SIZE_MB)
+	{
+		generation = 0;
+		Resize(size_mb);
+	}
+
+	// Reallocate the table to use at most the given number of megabytes, clearing its contents
+	void Resize(const int size_mb)
+	{
+		// Use the largest power of 2 number of buckets that fits
+		uint64_t max_buckets = (uint64_t(size_mb) * 1024 * 1024) / sizeof(TT_Bucket);
+		uint64_t num_buckets = 1;
+		while (num_buckets * 2 <= max_buckets)
+		{
+			num_buckets *= 2;
+		}
+
+		buckets = std::vector<TT_Bucket>(num_buckets);
+		index_mask = num_buckets - 1;
+
+		Clear();
+	}
+
+	// Empty every entry and reset the statistics. Must not be called while a search is running
+	void Clear()
+	{
+		for (uint64_t i = 0; i < buckets.size(); i++)
+		{
+			for (int j = 0; j < TT_BUCKET_SIZE; j++)
+			{
+				buckets[i].slots[j].key_xor_data.store(0, std::memory_order_relaxed);
+				buckets[i].slots[j].data.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		Clear_Stats();
+	}
+
+	// Reset the calling thread's usage statistics
+	void Clear_Stats()
+	{
+		TT_STATS = TT_Stats();
+	}
+
+	// Start a new search, so everything stored before it is preferred for replacement
+	void New_Search()
+	{
+		generation = (generation + 1) % TT_GENERATIONS;
+	}
+
+	// Pack the parts of an entry (other than the key) into one word
+	static uint64_t Pack_Data(const int depth, const uint8_t bound, const int score, const Move best_move, const uint8_t entry_generation)
+	{
+		return uint64_t(best_move)
+			 | (uint64_t(uint8_t(depth)) << 16)
+			 | (uint64_t(bound) << 24)
+			 | (uint64_t(entry_generation) << 26)
+			 | (uint64_t(uint32_t(score)) << 32);
+	}
+
+	// Unpack the parts of an entry's data word
+	static Move Data_Move(const uint64_t data)
+	{
+		return Move(data & 0xFFFF);
+	}
+
+	static int Data_Depth(const uint64_t data)
+	{
+		return int8_t((data >> 16) & 0xFF);
+	}
+
+	static uint8_t Data_Bound(const uint64_t data)
+	{
+		return (data >> 24) & 3;
+	}
+
+	static uint8_t Data_Generation(const uint64_t data)
+	{
+		return (data >> 26) & 63;
+	}
+
+	static int Data_Score(const uint64_t data)
+	{
+		return int32_t(uint32_t(data >> 32));
+	}
+
+	// Look up the given position. Returns true and fills in "entry" if it was found
+	bool Probe(const uint64_t key, TT_Entry& entry)
+	{
+		TT_STATS.probes++;
+
+		TT_Bucket& bucket = buckets[key & index_mask];
+
+		// Check each entry of the bucket for the position. The key check also throws out any
+		// entry another thread was halfway through writing
+		for (int i = 0; i < TT_BUCKET_SIZE; i++)
+		{
+			uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+			uint64_t stored_key = bucket.slots[i].key_xor_data.load(std::memory_order_relaxed) ^ data;
+
+			if (stored_key == key && Data_Bound(data) != EMPTY_BOUND)
+			{
+				entry.key = key;
+				entry.score = Data_Score(data);
+				entry.best_move = Data_Move(data);
+				entry.depth = Data_Depth(data);
+				entry.bound = Data_Bound(data);
+				TT_STATS.hits++;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Save the result of searching the given position
+	void Store(const uint64_t key, const int depth, const uint8_t bound, const int score, const Move best_move)
+	{
+		TT_Bucket& bucket = buckets[key & index_mask];
+		Move move_to_store = best_move;
+
+		// The position replaces its own older entry if it has one, unless that entry is worth
+		// more (see below). Otherwise it replaces the entry worth the least: empty entries first,
+		// then ones from the oldest searches, then the shallowest ones
+		int replace = 0;
+		int replace_worth = 0;
+		bool replace_used = false;
+		for (int i = 0; i < TT_BUCKET_SIZE; i++)
+		{
+			uint64_t data = bucket.slots[i].data.load(std::memory_order_relaxed);
+			uint64_t stored_key = bucket.slots[i].key_xor_data.load(std::memory_order_relaxed) ^ data;
+			bool used = (Data_Bound(data) != EMPTY_BOUND);
+
+			if (used && stored_key == key)
+			{
+				// A shallower bound from this same search (such as a reduced or verification
+				// re-search) knows less than the entry already there, so keep that one
+				if (depth < Data_Depth(data) && bound != EXACT_BOUND && Data_Generation(data) == generation)
+				{
+					return;
+				}
+
+				// Keep the old best move if this search did not find one
+				if (move_to_store == NULL_MOVE)
+				{
+					move_to_store = Data_Move(data);
+				}
+				replace = i;
+				replace_used = false;
+				break;
+			}
+
+			int age = (generation - Data_Generation(data) + TT_GENERATIONS) % TT_GENERATIONS;
+			int worth = (used ? Data_Depth(data) - TT_AGE_WEIGHT * age : -1000);
+			if (i == 0 || worth < replace_worth)
+			{
+				replace = i;
+				replace_worth = worth;
+				replace_used = used;
+			}
+		}
+
+		TT_STATS.stores++;
+		if (replace_used)
+		{
+			TT_STATS.collisions++;
+		}
+
+		int stored_depth = std::max(TT_MIN_DEPTH, std::min(depth, TT_MAX_DEPTH));
+		uint64_t data = Pack_Data(stored_depth, bound, score, move_to_store, generation);
+		bucket.slots[replace].data.store(data, std::memory_order_relaxed);
+		bucket.slots[replace].key_xor_data.store(key ^ data, std::memory_order_relaxed);
+	}
+
+	// Output the calling thread's usage statistics to the console
+	void Print_Stats()
+	{
+		// Sample the start of the table to estimate how much of it this search has filled
+		uint64_t sample = (buckets.size() < 1000 ? buckets.size() : 1000);
+		uint64_t used = 0;
+		for (uint64_t i = 0; i < sample; i++)
+		{
+			for (int j = 0; j < TT_BUCKET_SIZE; j++)
+			{
+				uint64_t data = buckets[i].slots[j].data.load(std::memory_order_relaxed);
+				used += (Data_Bound(data) != EMPTY_BOUND && Data_Generation(data) == generation);
+			}
+		}
+
+		std::cout << "\tTT: " << (buckets.size() * sizeof(TT_Bucket)) / (1024 * 1024) << " MB"
+				  << ", probes " << TT_STATS.probes
+				  << ", hits " << TT_STATS.hits << " (" << (TT_STATS.probes ? 100 * TT_STATS.hits / TT_STATS.probes : 0) << "%)"
+				  << ", stores " << TT_STATS.stores
+				  << ", collisions " << TT_STATS.collisions
+				  << ", full " << (sample ? 100 * used / (TT_BUCKET_SIZE * sample) : 0) << "%\n";
+	}
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include <iostream>
+
+#include "uci.hpp"
+
+
+// UCI engine for playing through a chess GUI. "make chess" builds it (see the Makefile, which also
+// builds the self-play demo and tools from main.cpp)
+int main()
+{
+	// Commands have to be answered as soon as they are handled, not when a buffer fills up
+	std::cout.setf(std::ios::unitbuf);
+
+	UCI_Engine engine;
+	engine.Run(std::cin);
+
+	return 0;
+}
@@ -0,0 +1,397 @@
+#ifndef UCI_HPP
+#define UCI_HPP
+
+#include "gamestate.hpp"
+#include "game_logic.hpp"
+#include "algorithms.hpp"
+#include "time_manager.hpp"
+
+#include <iostream>
+#include <sstream> // istringstream
+#include <string>
+#include <vector>
+#include <cstdlib> // atoi, atoll
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+// Name reported to the GUI
+const std::string ENGINE_NAME = "CS5400-Chess";
+const std::string ENGINE_AUTHOR = "tmorgan181";
+
+// Range of the "Hash" option, in megabytes
+const int MIN_HASH_MB = 1;
+const int MAX_HASH_MB = 4096;
+
+
+// Talks to a chess GUI over the Universal Chess Interface (UCI): commands come in one per line on
+// standard input, and replies go out on standard output. The search runs on a thread of its own,
+// so commands (above all "stop") are still read and answered while it is thinking
+class UCI_Engine
+{
+public:
+	Gamestate position;					// position set by the last "position" command
+	Search_Limits limits;				// limits of the search the last "go" asked for
+
+	std::thread worker;					// runs every search, and waits for the next one in between
+	std::mutex mutex;					// guards everything below
+	std::condition_variable wake;		// signalled whenever one of the flags below changes
+	bool search_requested;				// a "go" is waiting for the worker to pick it up
+	bool searching;						// the worker is busy with a search (until its "bestmove")
+	bool stop_requested;				// "stop" came in for the current search
+	bool pondering;						// the current search is a "go ponder" still waiting for "ponderhit"
+	bool new_game;						// "ucinewgame" came in since the last search
+	bool quitting;						// the worker should exit
+
+	UCI_Engine()
+	{
+		search_requested = false;
+		searching = false;
+		stop_requested = false;
+		pondering = false;
+		new_game = false;
+		quitting = false;
+
+		SEARCH_OPTIONS.uci_output = true;
+		worker = std::thread(&UCI_Engine::Search_Thread_Loop, this);
+	}
+
+	~UCI_Engine()
+	{
+		Stop_Search();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quitting = true;
+		}
+		wake.notify_all();
+		worker.join();
+	}
+
+	// Read and carry out commands until "quit" or the end of the input
+	void Run(std::istream& input)
+	{
+		std::string line;
+		while (std::getline(input, line))
+		{
+			if (!Handle_Command(line))
+			{
+				break;
+			}
+		}
+	}
+
+	// Carry out one command. Returns false if it was "quit"
+	bool Handle_Command(const std::string line)
+	{
+		std::istringstream tokens(line);
+		std::string command;
+		tokens >> command;
+
+		if (command == "uci")
+		{
+			Send_Line("id name " + ENGINE_NAME);
+			Send_Line("id author " + ENGINE_AUTHOR);
+			Send_Line("option name Hash type spin default " + std::to_string(DEFAULT_TT_SIZE_MB)
+					  + " min " + std::to_string(MIN_HASH_MB) + " max " + std::to_string(MAX_HASH_MB));
+			Send_Line("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_SEARCH_THREADS));
+			Send_Line("option name Ponder type check default false");
+			Send_Line("uciok");
+		}
+		else if (command == "isready")
+		{
+			// Answered straight away, even in the middle of a search
+			Send_Line("readyok");
+		}
+		else if (command == "ucinewgame")
+		{
+			// Nothing learned in the last game applies to the next one. The move orderer belongs to
+			// the worker thread, so it clears that itself before its next search
+			Wait_For_Search();
+			TRANSPOSITION_TABLE.Clear();
+			std::lock_guard<std::mutex> lock(mutex);
+			new_game = true;
+		}
+		else if (command == "setoption")
+		{
+			Handle_Setoption(tokens);
+		}
+		else if (command == "position")
+		{
+			Wait_For_Search();
+			Handle_Position(tokens);
+		}
+		else if (command == "go")
+		{
+			Handle_Go(tokens);
+		}
+		else if (command == "ponderhit")
+		{
+			Ponder_Hit();
+		}
+		else if (command == "stop")
+		{
+			Stop_Search();
+		}
+		else if (command == "quit")
+		{
+			return false;
+		}
+
+		// Anything else is ignored, as the protocol asks
+		return true;
+	}
+
+	// "position [startpos | fen <fen>] [moves <move> ...]"
+	void Handle_Position(std::istringstream& tokens)
+	{
+		std::string token;
+		tokens >> token;
+
+		if (token == "startpos")
+		{
+			position = Gamestate();
+			tokens >> token;
+		}
+		else if (token == "fen")
+		{
+			// The FEN is every token up to "moves" (or the end of the line)
+			std::vector<std::string> fields;
+			while (tokens >> token && token != "moves")
+			{
+				fields.push_back(token);
+			}
+
+			// GUIs often leave out the move counters, but the board, side to move, castles, and
+			// en passant square are needed. Without them the position is left as it was
+			if (fields.size() < 4)
+			{
+				return;
+			}
+			if (fields.size() < 5)
+			{
+				fields.push_back("0");
+			}
+			if (fields.size() < 6)
+			{
+				fields.push_back("1");
+			}
+
+			std::string fen = fields[0];
+			for (int i = 1; i < 6; i++)
+			{
+				fen += " " + fields[i];
+			}
+			position = Gamestate(fen);
+		}
+		else
+		{
+			return;
+		}
+
+		// Play the moves that led from there to the current position. The undo records are not
+		// needed, since the moves are never taken back
+		if (token == "moves")
+		{
+			Undo_Record undo;
+			while (tokens >> token)
+			{
+				Move m = Parse_Move(position, token);
+				if (m == NULL_MOVE)
+				{
+					break;
+				}
+				Make_Move(position, m, undo);
+			}
+		}
+	}
+
+	// "go [ponder] [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>]
+	//     [binc <ms>] [movestogo <n>] [infinite]". Starts the search and returns straight away. The
+	//     position of "go ponder" already includes the reply being pondered on
+	void Handle_Go(std::istringstream& tokens)
+	{
+		Wait_For_Search();
+
+		Search_Limits new_limits;
+		std::string token;
+		while (tokens >> token)
+		{
+			if (token == "depth")
+			{
+				// Iteration n searches n + 1 plies, so "depth n" stops after iteration n - 1
+				int depth = 1;
+				tokens >> depth;
+				new_limits.depth = std::max(depth - 1, 0);
+			}
+			else if (token == "nodes")
+			{
+				tokens >> new_limits.nodes;
+			}
+			else if (token == "movetime")
+			{
+				tokens >> new_limits.movetime;
+			}
+			else if (token == "wtime")
+			{
+				tokens >> new_limits.wtime;
+			}
+			else if (token == "btime")
+			{
+				tokens >> new_limits.btime;
+			}
+			else if (token == "winc")
+			{
+				tokens >> new_limits.winc;
+			}
+			else if (token == "binc")
+			{
+				tokens >> new_limits.binc;
+			}
+			else if (token == "movestogo")
+			{
+				tokens >> new_limits.movestogo;
+			}
+			else if (token == "infinite")
+			{
+				new_limits.infinite = true;
+			}
+			else if (token == "ponder")
+			{
+				new_limits.ponder = true;
+			}
+		}
+
+		// A bare "go" has no limit at all, the same as "go infinite"
+		if (new_limits.depth < 0 && new_limits.nodes == 0 && new_limits.movetime == 0
+			&& new_limits.wtime == 0 && new_limits.btime == 0)
+		{
+			new_limits.infinite = true;
+		}
+
+		// ID_DL_Minimax() does not clear the abort flag or a ponder hit when it starts, so clear
+		// them here, before a "stop" or "ponderhit" for this search could come in
+		SEARCH_ABORTED = false;
+		TIME_MANAGER.ponder_hit_pending = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			limits = new_limits;
+			stop_requested = false;
+			pondering = new_limits.ponder;
+			search_requested = true;
+			searching = true;
+		}
+		wake.notify_all();
+	}
+
+	// "setoption name <name> value <value>"
+	void Handle_Setoption(std::istringstream& tokens)
+	{
+		// Names may be more than one word, so collect everything between "name" and "value"
+		std::string token, name = "", value = "";
+		tokens >> token;
+		while (tokens >> token && token != "value")
+		{
+			name += (name.empty() ? "" : " ") + token;
+		}
+		tokens >> value;
+
+		// Options are never changed under a running search
+		Wait_For_Search();
+		if (name == "Hash")
+		{
+			int size_mb = std::max(MIN_HASH_MB, std::min(atoi(value.c_str()), MAX_HASH_MB));
+			TRANSPOSITION_TABLE.Resize(size_mb);
+		}
+		else if (name == "Threads")
+		{
+			SEARCH_OPTIONS.threads = std::max(1, std::min(atoi(value.c_str()), MAX_SEARCH_THREADS));
+		}
+	}
+
+	// The opponent played the move being pondered on: the ponder search carries on as a normal
+	// search of our move, with the time limits its "go" gave, keeping everything it has found
+	void Ponder_Hit()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!searching || !pondering)
+			{
+				return;
+			}
+			pondering = false;
+			TIME_MANAGER.Ponder_Hit();
+		}
+		wake.notify_all();
+	}
+
+	// Stop the running search, if there is one, and wait for it to send its "bestmove". When
+	// pondering, this means the opponent played something else. The next search starts from
+	// scratch, but the transposition table keeps what the ponder search stored
+	void Stop_Search()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (searching)
+			{
+				stop_requested = true;
+				SEARCH_ABORTED = true;
+			}
+		}
+		wake.notify_all();
+		Wait_For_Search();
+	}
+
+	// Wait until the worker has finished its search, if it has one
+	void Wait_For_Search()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [this] { return !searching; });
+	}
+
+	// Body of the worker thread: search each position "go" hands over, and report the move
+	void Search_Thread_Loop()
+	{
+		while (true)
+		{
+			// Wait for work, and take a copy of it so the command thread is free to carry on
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return search_requested || quitting; });
+			if (quitting)
+			{
+				return;
+			}
+			search_requested = false;
+			Gamestate search_position(position);
+			Search_Limits search_limits(limits);
+			if (new_game)
+			{
+				MOVE_ORDERER.Clear();
+				new_game = false;
+			}
+			lock.unlock();
+
+			Move best_move = ID_DL_Minimax(search_position, search_limits);
+
+			// An infinite search that ran out of depths still may not answer before "stop", and a
+			// ponder search not before "stop" or "ponderhit"
+			lock.lock();
+			bool infinite = search_limits.infinite;
+			wake.wait(lock, [this, infinite] { return stop_requested || quitting || (!infinite && !pondering); });
+
+			// Also name the reply expected, so the GUI can let us ponder on it
+			std::string reply = (best_move == NULL_MOVE ? std::string("0000") : Move_to_UCI(best_move));
+			if (best_move != NULL_MOVE && PONDER_MOVE != NULL_MOVE)
+			{
+				reply += " ponder " + Move_to_UCI(PONDER_MOVE);
+			}
+			Send_Line("bestmove " + reply);
+			pondering = false;
+			searching = false;
+			lock.unlock();
+			wake.notify_all();
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include "bitboard.hpp"
+
+
+// Zobrist hashing gives every position a 64-bit key by XOR-ing together one random number for
+// each feature of the position. Since XOR undoes itself, a move only has to XOR out the features
+// it removes and XOR in the ones it adds to keep the key up to date
+
+// One key per piece on each square, indexed [color][type][square]
+uint64_t ZOBRIST_PIECES[2][6][64];
+
+// XOR-ed in when it is black's turn
+uint64_t ZOBRIST_BLACK_TO_MOVE;
+
+// One key per combination of Gamestate::castling_rights bits
+uint64_t ZOBRIST_CASTLING[16];
+
+// One key per file of the en passant target
+uint64_t ZOBRIST_EN_PASSANT[8];
+
+
+//////// Function Declarations ////////
+
+// Get the next number from a xorshift random number generator, advancing its state
+inline uint64_t Random_U64(uint64_t& state);
+
+// Fill in the key tables, unless that has been done already
+void Init_Zobrist();
+
+
+//////// Function Implementations ////////
+
+inline uint64_t Random_U64(uint64_t& state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 0x2545F4914F6CDD1DULL;
+}
+
+void Init_Zobrist()
+{
+	static const bool initialized = []
+	{
+		// Use a fixed seed so keys are the same on every run
+		uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+		for (int color = 0; color < 2; color++)
+		{
+			for (int type = 0; type < 6; type++)
+			{
+				for (int sq = 0; sq < 64; sq++)
+				{
+					ZOBRIST_PIECES[color][type][sq] = Random_U64(seed);
+				}
+			}
+		}
+
+		ZOBRIST_BLACK_TO_MOVE = Random_U64(seed);
+
+		// No castling rights at all leaves the key unchanged
+		ZOBRIST_CASTLING[0] = 0;
+		for (int i = 1; i < 16; i++)
+		{
+			ZOBRIST_CASTLING[i] = Random_U64(seed);
+		}
+
+		for (int file = 0; file < 8; file++)
+		{
+			ZOBRIST_EN_PASSANT[file] = Random_U64(seed);
+		}
+
+		return true;
+	}();
+	(void)initialized;
+}
+
+#endif